@@ -0,0 +1,163 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** backgroundsearch.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "backgroundsearch.hpp"
+
+#include <QMutex>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+
+#include "textbuffer.hpp"
+#include "textsearcher.hpp"
+
+namespace
+{
+// Lets a task tell whether the search it reports to still exists.
+struct Link
+{
+	QMutex mutex;
+	BackgroundSearch *owner;
+};
+}
+
+struct BackgroundSearch::Impl
+{
+	// Runs the search, which returns the start of the match and stores its length.
+	using SearchFunc = std::function<qint64(std::atomic<bool> const &cancelled, qint64 &length)>;
+
+	Impl(BackgroundSearch *top) :
+	    link(std::make_shared<Link>())
+	{
+		pool.setMaxThreadCount(1);
+		link->owner = top;
+	}
+
+	void launch(SearchFunc search)
+	{
+		if (cancelled)
+		{
+			cancelled->store(true);
+		}
+
+		cancelled = std::make_shared<std::atomic<bool>>(false);
+		auto task = [link = link, flag = cancelled, current = ++generation, search = std::move(search)]() {
+			qint64 length = 0;
+			const qint64 start = search(*flag, length);
+			if (flag->load())
+			{
+				return;
+			}
+
+			QMutexLocker locker(&link->mutex);
+			if (link->owner)
+			{
+				QMetaObject::invokeMethod(link->owner, "finished", Qt::QueuedConnection, Q_ARG(quint64, current),
+				                          Q_ARG(qint64, start), Q_ARG(qint64, length));
+			}
+		};
+
+		pool.start(std::move(task));
+	}
+
+	// Searches run on a pool of their own, since a literal one spreads its chunks over the global pool and waits for
+	// them.  With a single thread a search only starts once the one before it has noticed it was cancelled.
+	QThreadPool pool;
+	std::shared_ptr<Link> link;
+	std::shared_ptr<std::atomic<bool>> cancelled;
+	quint64 generation = 0;
+};
+
+BackgroundSearch::BackgroundSearch(QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<BackgroundSearch::Impl>(this))
+{
+	// No implementation.
+}
+
+BackgroundSearch::~BackgroundSearch()
+{
+	cancel();
+	QMutexLocker locker(&im->link->mutex);
+	im->link->owner = nullptr;
+}
+
+void BackgroundSearch::start(FindFlags flags, QString const &seek, QString const &text, qint64 from)
+{
+	im->launch([flags, seek, text, from](std::atomic<bool> const &cancelled, qint64 &length) {
+		const TextSearcher searcher(flags, seek);
+		const bool backward = flags.test(0);
+		qint64 start = searcher.findInRawText(text, from, backward, length, &cancelled);
+		if (start < 0 && flags.test(4))
+		{
+			start = searcher.findInRawText(text, backward ? text.size() : 0, backward, length, &cancelled);
+		}
+
+		return start;
+	});
+}
+
+void BackgroundSearch::start(FindFlags flags, QString const &seek, TextBuffer const &buffer, qint64 from)
+{
+	im->launch([flags, seek, buffer, from](std::atomic<bool> const &cancelled, qint64 &length) {
+		const TextSearcher searcher(flags, seek);
+		const bool backward = flags.test(0);
+		length = searcher.byteLength();
+		qint64 start = searcher.find(buffer, from, backward, &cancelled);
+		if (start < 0 && flags.test(4))
+		{
+			start = searcher.find(buffer, backward ? buffer.size() : 0, backward, &cancelled);
+		}
+
+		return start;
+	});
+}
+
+void BackgroundSearch::cancel()
+{
+	if (im->cancelled)
+	{
+		im->cancelled->store(true);
+	}
+
+	// Whatever is already queued for delivery is dropped as well.
+	++im->generation;
+}
+
+void BackgroundSearch::wait()
+{
+	im->pool.waitForDone();
+}
+
+void BackgroundSearch::finished(quint64 generation, qint64 start, qint64 length)
+{
+	if (generation != im->generation)
+	{
+		return;
+	}
+
+	if (start < 0)
+	{
+		emit notFound();
+	}
+	else
+	{
+		emit found(start, length);
+	}
+}
@@ -0,0 +1,57 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** backgroundsearch.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QObject>
+
+#include <memory>
+
+#include "findflags.hpp"
+
+class TextBuffer;
+
+// Runs one search at a time on a thread of its own.  Starting a search cancels the previous one, and only the result of
+// the latest search is ever reported, so nothing waits for a search that is no longer wanted.
+class BackgroundSearch : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit BackgroundSearch(QObject *parent = nullptr);
+	~BackgroundSearch();
+
+	// Searches a snapshot of the text, laid out like QTextDocument::toRawText.
+	void start(FindFlags flags, QString const &seek, QString const &text, qint64 from);
+	// Searches a snapshot of the buffer for a literal string, the result is in bytes.
+	void start(FindFlags flags, QString const &seek, TextBuffer const &buffer, qint64 from);
+	void cancel();
+	// Blocks until no search is running anymore, which after cancel() is never long.
+	void wait();
+
+signals:
+	void found(qint64 start, qint64 length);
+	void notFound();
+
+private slots:
+	void finished(quint64 generation, qint64 start, qint64 length);
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
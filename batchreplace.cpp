@@ -0,0 +1,255 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** batchreplace.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "batchreplace.hpp"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include <vector>
+
+#include "textencoding.hpp"
+
+// Files are read and written this much at a time, so memory stays flat however large they are.
+constexpr qint64 CHUNK_SIZE = 1 << 20;
+
+namespace
+{
+bool isBreak(QChar c)
+{
+	return c == QChar('\n') || c == QChar('\r');
+}
+}
+
+BatchReplace::BatchReplace(FindFlags flags, QString const &seek) :
+    searcher(flags, seek),
+    replacing(false),
+    inPlace(false)
+{
+	// No implementation.
+}
+
+bool BatchReplace::isValid() const
+{
+	return searcher.isValid();
+}
+
+void BatchReplace::setReplacement(QString const &replace, bool inPlace)
+{
+	searcher.setReplacement(replace);
+	replacing = true;
+	this->inPlace = inPlace;
+}
+
+int BatchReplace::run(QStringList const &files) const
+{
+	std::vector<Result> results(files.size());
+	QThreadPool pool;
+	for (qsizetype i = 0; i < files.size(); ++i)
+	{
+		pool.start([this, &files, &results, i]() { results[i] = process(files[i]); });
+	}
+
+	pool.waitForDone();
+
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+	bool matched = false, failed = false;
+	for (qsizetype i = 0; i < files.size(); ++i)
+	{
+		Result const &result = results[i];
+		if (!result.error.isEmpty())
+		{
+			err << tr("%1: %2").arg(files[i], result.error) << Qt::endl;
+			failed = true;
+			continue;
+		}
+
+		matched = matched || result.matches > 0;
+		if (inPlace)
+		{
+			out << tr("%1: %Ln replacement(s)", "", result.matches).arg(files[i]) << Qt::endl;
+		}
+		else
+		{
+			out << tr("%1: %Ln match(es)", "", result.matches).arg(files[i]) << Qt::endl;
+		}
+	}
+
+	return failed ? 2 : matched ? 0 : 1;
+}
+
+BatchReplace::Result BatchReplace::process(QString const &fileName) const
+{
+	Result result;
+	QFile file(fileName);
+	if (!file.open(QIODeviceBase::ReadOnly))
+	{
+		result.error = file.errorString();
+		return result;
+	}
+
+	// The new text goes next to the file and only replaces it once all of it was written, and only when something
+	// was replaced at all, so a file without a match is never touched.
+	std::optional<QSaveFile> output;
+	if (inPlace && replacing)
+	{
+		output.emplace(fileName);
+		if (!output->open(QIODeviceBase::WriteOnly))
+		{
+			result.error = output->errorString();
+			return result;
+		}
+	}
+
+	std::optional<QStringDecoder> decoder;
+	std::optional<QStringEncoder> encoder;
+	QByteArray partial;
+	bool checking = false;
+	bool allAscii = true;
+	QString pending;
+	QString replaced;
+	while (!file.atEnd())
+	{
+		QByteArray bytes = file.read(CHUNK_SIZE);
+		if (bytes.isEmpty())
+		{
+			result.error = file.errorString();
+			return result;
+		}
+
+		const bool atEnd = file.atEnd();
+		if (!decoder)
+		{
+			const TextEncoding encoding = TextEncoding::detect(bytes.constData(), bytes.size(), atEnd);
+			checking = encoding.isUtf8();
+			decoder.emplace(encoding.decoder());
+			encoder.emplace(encoding.encoder());
+		}
+
+		// The same check the editor makes while loading, except that a file it would have to decode with
+		// replacement characters is refused instead, as writing it back would lose whatever they stand for.
+		if (checking)
+		{
+			const QByteArray checked = partial + bytes;
+			bool truncated = false;
+			const qint64 valid = TextEncoding::validUtf8(checked.constData(), checked.size(), truncated);
+			allAscii = allAscii && TextEncoding::isAscii(checked.constData(), valid);
+			partial = checked.mid(valid);
+			if (valid < checked.size() && (!truncated || atEnd))
+			{
+				if (!allAscii)
+				{
+					result.error = tr("Not valid UTF-8, left as it is.");
+					return result;
+				}
+
+				// Everything so far was ASCII, so the UTF-8 decoder only holds back the partial sequence, which
+				// Latin-1 takes along with the rest of the chunk.
+				checking = false;
+				const TextEncoding latin1(QStringConverter::Latin1);
+				decoder.emplace(latin1.decoder());
+				encoder.emplace(latin1.encoder());
+				bytes = checked;
+			}
+		}
+
+		pending.append(decoder->decode(bytes));
+
+		// Only whole lines are searched, as the editor searches each block on its own, so the last line waits for
+		// the rest of it.  A \r at the very end may still be followed by the \n of the same line break.
+		qsizetype end = pending.size();
+		if (!atEnd)
+		{
+			if (end > 0 && pending.at(end - 1) == QChar('\r'))
+			{
+				--end;
+			}
+
+			while (end > 0 && !isBreak(pending.at(end - 1)))
+			{
+				--end;
+			}
+		}
+
+		result.matches += processLines(pending, end, output ? &replaced : nullptr);
+		pending.remove(0, end);
+		if (output && !replaced.isEmpty())
+		{
+			if (output->write(encoder->encode(replaced)) < 0)
+			{
+				result.error = output->errorString();
+				return result;
+			}
+
+			replaced.clear();
+		}
+	}
+
+	if (output && result.matches > 0 && !output->commit())
+	{
+		result.error = output->errorString();
+	}
+	else if (output && result.matches == 0)
+	{
+		output->cancelWriting();
+	}
+
+	return result;
+}
+
+qint64 BatchReplace::processLines(QString const &text, qsizetype end, QString *out) const
+{
+	qint64 matches = 0;
+	qsizetype start = 0;
+	while (start < end)
+	{
+		qsizetype stop = start;
+		while (stop < end && !isBreak(text.at(stop)))
+		{
+			++stop;
+		}
+
+		qsizetype next = stop;
+		if (next < end)
+		{
+			next += (text.at(next) == QChar('\r') && next + 1 < end && text.at(next + 1) == QChar('\n')) ? 2 : 1;
+		}
+
+		// The line is searched where it lies, and its line break is kept just as it was.
+		const QString line = QString::fromRawData(text.constData() + start, stop - start);
+		if (out)
+		{
+			matches += searcher.replaceInto(line, *out);
+			out->append(QStringView(text).sliced(stop, next - stop));
+		}
+		else
+		{
+			searcher.forEachMatch(line, [&matches](qsizetype, qsizetype) {
+				++matches;
+				return true;
+			});
+		}
+
+		start = next;
+	}
+
+	return matches;
+}
@@ -0,0 +1,64 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** batchreplace.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+
+#include "findflags.hpp"
+#include "textsearcher.hpp"
+
+// Find and replace over files from the command line, without a window.  Matches are found line by line with the same
+// TextSearcher the Replace All of the dialog uses, so a script makes exactly the edits the editor would.
+//
+// Each file is streamed through in chunks rather than loaded whole, and the files are spread over the thread pool so
+// as many are worked on at once as there are cores.
+class BatchReplace
+{
+	Q_DECLARE_TR_FUNCTIONS(BatchReplace)
+
+public:
+	BatchReplace(FindFlags flags, QString const &seek);
+
+	bool isValid() const;
+	// Without inPlace the replacements are only counted, the files are left as they are.
+	void setReplacement(QString const &replace, bool inPlace);
+
+	// Reports the number of matches in each file, in the order given, and any file that could not be handled.
+	// Returns 0 when something matched, 1 when nothing did and 2 when a file failed, as grep does.
+	int run(QStringList const &files) const;
+
+private:
+	struct Result
+	{
+		qint64 matches = 0;
+		QString error;
+	};
+
+	Result process(QString const &fileName) const;
+	// Searches the whole lines in text up to end, appending them to out with their line breaks when it is set.
+	qint64 processLines(QString const &text, qsizetype end, QString *out) const;
+
+	TextSearcher searcher;
+	bool replacing;
+	bool inPlace;
+};
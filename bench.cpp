@@ -0,0 +1,284 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** bench.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include <QtTest>
+#include <QFile>
+#include <QMap>
+#include <QStatusBar>
+#include <QTemporaryDir>
+
+#include <iterator>
+
+#include "findflags.hpp"
+#include "maintextedit.hpp"
+#include "mainwindow.hpp"
+
+// Synthetic files generated, in MiB.  Anything over SIMPLETEXTEDIT_BENCH_MAX_MB is skipped for quicker runs.
+constexpr qint64 FILE_SIZES[] = { 1, 16, 128, 1024 };
+// How long a load or save in the background may take before the benchmark gives up on it.
+constexpr int BACKGROUND_TIMEOUT = 10 * 60 * 1000;
+// Found once in every hundred lines, while the sentinel only ends the file, so finding it scans all of the text.
+const QString NEEDLE = QStringLiteral("needle42");
+const QString SENTINEL = QStringLiteral("sentinel31337");
+
+// Times the editor through the same slots the menus and dialogs of MainWindow call.  Results come out in any of the
+// QtTest formats, for instance -o results.csv,csv or -o results.xml,xml, so they can be compared between releases.
+class SimpleTextEditBench : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+
+	void open_data();
+	void open();
+	void save_data();
+	void save();
+	void findLiteral_data();
+	void findLiteral();
+	void findRegex_data();
+	void findRegex();
+	void replaceAll_data();
+	void replaceAll();
+	void zoom_data();
+	void zoom();
+	void wordWrap_data();
+	void wordWrap();
+
+private:
+	void addSizes();
+	QString fileFor(qint64 megabytes);
+	void load(MainWindow &window, QString const &file);
+	void waitUntilIdle(MainWindow &window);
+	void find(MainWindow &window, FindFlags flags, QString const &seek);
+
+	QTemporaryDir dir;
+	QMap<qint64, QString> files;
+	qint64 maxMegabytes = FILE_SIZES[std::size(FILE_SIZES) - 1];
+};
+
+void SimpleTextEditBench::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	bool ok = false;
+	if (const qint64 limit = qEnvironmentVariableIntValue("SIMPLETEXTEDIT_BENCH_MAX_MB", &ok); ok)
+	{
+		maxMegabytes = limit;
+	}
+}
+
+void SimpleTextEditBench::open_data()
+{
+	addSizes();
+}
+
+void SimpleTextEditBench::open()
+{
+	QFETCH(qint64, megabytes);
+	const QString file = fileFor(megabytes);
+	MainWindow window;
+	window.show();
+	QVERIFY(QTest::qWaitForWindowExposed(&window));
+	QBENCHMARK_ONCE
+	{
+		window.loadFile(file);
+		waitUntilIdle(window);
+	}
+}
+
+void SimpleTextEditBench::save_data()
+{
+	addSizes();
+}
+
+void SimpleTextEditBench::save()
+{
+	QFETCH(qint64, megabytes);
+	MainWindow window;
+	load(window, fileFor(megabytes));
+	QBENCHMARK_ONCE
+	{
+		window.saveFile();
+		waitUntilIdle(window);
+	}
+}
+
+void SimpleTextEditBench::findLiteral_data()
+{
+	addSizes();
+}
+
+void SimpleTextEditBench::findLiteral()
+{
+	QFETCH(qint64, megabytes);
+	MainWindow window;
+	load(window, fileFor(megabytes));
+	QBENCHMARK
+	{
+		find(window, FFlags::None, SENTINEL);
+	}
+}
+
+void SimpleTextEditBench::findRegex_data()
+{
+	addSizes();
+}
+
+void SimpleTextEditBench::findRegex()
+{
+	QFETCH(qint64, megabytes);
+	MainWindow window;
+	load(window, fileFor(megabytes));
+	QBENCHMARK
+	{
+		find(window, FFlags::FindByRegex, QStringLiteral("sentinel\\d+"));
+	}
+}
+
+void SimpleTextEditBench::replaceAll_data()
+{
+	addSizes();
+}
+
+void SimpleTextEditBench::replaceAll()
+{
+	QFETCH(qint64, megabytes);
+	MainWindow window;
+	load(window, fileFor(megabytes));
+	QBENCHMARK_ONCE
+	{
+		QMetaObject::invokeMethod(&window, "doReplaceAllRequest", Q_ARG(FindFlags, FFlags::None),
+		                          Q_ARG(QString, NEEDLE), Q_ARG(QString, QStringLiteral("pin42")));
+	}
+}
+
+void SimpleTextEditBench::zoom_data()
+{
+	addSizes();
+}
+
+void SimpleTextEditBench::zoom()
+{
+	QFETCH(qint64, megabytes);
+	MainWindow window;
+	load(window, fileFor(megabytes));
+	QWidget *viewport = window.findChild<MainTextEdit *>()->viewport();
+	QBENCHMARK
+	{
+		// Zoom steps are gathered on a timer, which is cut short here.
+		window.zoomIn();
+		QMetaObject::invokeMethod(&window, "applyZoom");
+		viewport->repaint();
+		window.zoomOut();
+		QMetaObject::invokeMethod(&window, "applyZoom");
+		viewport->repaint();
+	}
+}
+
+void SimpleTextEditBench::wordWrap_data()
+{
+	addSizes();
+}
+
+void SimpleTextEditBench::wordWrap()
+{
+	QFETCH(qint64, megabytes);
+	MainWindow window;
+	load(window, fileFor(megabytes));
+	QWidget *viewport = window.findChild<MainTextEdit *>()->viewport();
+	QBENCHMARK
+	{
+		window.wordWrap(true);
+		viewport->repaint();
+		window.wordWrap(false);
+		viewport->repaint();
+	}
+}
+
+void SimpleTextEditBench::addSizes()
+{
+	QTest::addColumn<qint64>("megabytes");
+	for (qint64 megabytes : FILE_SIZES)
+	{
+		if (megabytes <= maxMegabytes)
+		{
+			QTest::newRow(QByteArray::number(megabytes) + " MiB") << megabytes;
+		}
+	}
+}
+
+// Lines of ordinary prose, long enough to wrap in a narrow window, written once and reused by every benchmark.
+QString SimpleTextEditBench::fileFor(qint64 megabytes)
+{
+	if (files.contains(megabytes))
+	{
+		return files[megabytes];
+	}
+
+	const QString name = dir.filePath(QString::number(megabytes) + ".txt");
+	QFile file(name);
+	if (!file.open(QIODeviceBase::WriteOnly))
+	{
+		return QString();
+	}
+
+	const QByteArray line = "The quick brown fox jumps over the lazy dog while the benchmark keeps time, "
+	                        "line after line of it.\n";
+	const QByteArray marked = "The quick brown fox finds a " + NEEDLE.toLatin1() + " in the haystack.\n";
+	QByteArray chunk;
+	for (int i = 0; chunk.size() < (1 << 20); ++i)
+	{
+		chunk += i % 100 == 0 ? marked : line;
+	}
+
+	const qint64 size = megabytes << 20;
+	for (qint64 written = 0; written < size; written += chunk.size())
+	{
+		file.write(chunk);
+	}
+
+	file.write(SENTINEL.toLatin1() + "\n");
+	files.insert(megabytes, name);
+	return name;
+}
+
+void SimpleTextEditBench::load(MainWindow &window, QString const &file)
+{
+	window.show();
+	QVERIFY(QTest::qWaitForWindowExposed(&window));
+	window.loadFile(file);
+	waitUntilIdle(window);
+}
+
+// Loads and saves both run in the background, and hold the editor read-only or a message up until they are done.
+void SimpleTextEditBench::waitUntilIdle(MainWindow &window)
+{
+	MainTextEdit *editor = window.findChild<MainTextEdit *>();
+	QTRY_VERIFY_WITH_TIMEOUT(!editor->isReadOnly() && window.statusBar()->currentMessage().isEmpty(),
+	                         BACKGROUND_TIMEOUT);
+}
+
+// Find Next from the top of the document, the way the dialog asks for it.
+void SimpleTextEditBench::find(MainWindow &window, FindFlags flags, QString const &seek)
+{
+	window.findChild<MainTextEdit *>()->moveCursor(QTextCursor::Start);
+	QMetaObject::invokeMethod(&window, "doFindRequest", Q_ARG(FindFlags, flags), Q_ARG(QString, seek));
+}
+
+QTEST_MAIN(SimpleTextEditBench)
+#include "bench.moc"
@@ -0,0 +1,282 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** editjournal.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "editjournal.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QMutex>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <QUuid>
+#include <QWaitCondition>
+
+#include <optional>
+#include <utility>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+// How long edits gather before they are written out, which turns a burst of typing into a single write and sync.
+constexpr int FLUSH_INTERVAL = 1000;
+constexpr quint32 JOURNAL_MAGIC = 0x5354454A;
+constexpr quint32 JOURNAL_VERSION = 1;
+
+namespace
+{
+QString journalDir()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/journal";
+}
+
+// Together with its size, tells whether a file is still the one a journal started from.
+qint64 modifiedTime(QFileInfo const &info)
+{
+	return info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+}
+
+bool syncToDisk(QFile &file)
+{
+	if (!file.flush())
+	{
+		return false;
+	}
+
+#if defined(Q_OS_UNIX)
+	return ::fsync(file.handle()) == 0;
+#elif defined(Q_OS_WIN)
+	return ::_commit(file.handle()) == 0;
+#else
+	return true;
+#endif
+}
+}
+
+struct EditJournal::Impl
+{
+	Impl(QString const &fileName, Units units) :
+	    fileName(fileName),
+	    units(units)
+	{
+		const QFileInfo info(fileName);
+		fileSize = fileName.isEmpty() ? 0 : info.size();
+		fileModified = fileName.isEmpty() ? 0 : modifiedTime(info);
+		timer.setSingleShot(true);
+		timer.setInterval(FLUSH_INTERVAL);
+	}
+
+	// The journal is only created with the first batch, most documents are opened and closed without an edit.
+	void open()
+	{
+		if (!QDir().mkpath(journalDir()))
+		{
+			return;
+		}
+
+		path = journalDir() + '/' + QUuid::createUuid().toString(QUuid::WithoutBraces) + ".journal";
+		lock.emplace(path + ".lock");
+		lock->setStaleLockTime(0);
+		if (!lock->tryLock(0))
+		{
+			lock.reset();
+			path.clear();
+			return;
+		}
+
+		QDataStream header(&pending, QIODeviceBase::WriteOnly);
+		header.setVersion(QDataStream::Qt_6_0);
+		header << JOURNAL_MAGIC << JOURNAL_VERSION << fileName << qint32(units) << fileSize << fileModified;
+		writer = QThread::create([this]() { writeLoop(); });
+		writer->start(QThread::LowPriority);
+	}
+
+	// A journal that cannot be written is given up on quietly, it is a safety net and the editor works without it.
+	void writeLoop()
+	{
+		QFile file(path);
+		bool ok = file.open(QIODeviceBase::WriteOnly | QIODeviceBase::Append);
+		QMutexLocker locker(&mutex);
+		forever
+		{
+			while (pending.isEmpty() && !closing)
+			{
+				changed.wait(&mutex);
+			}
+
+			if (pending.isEmpty())
+			{
+				return;
+			}
+
+			const QByteArray batch = std::exchange(pending, QByteArray());
+			locker.unlock();
+			ok = ok && file.write(batch) == batch.size() && syncToDisk(file);
+			locker.relock();
+		}
+	}
+
+	QString fileName;
+	Units units;
+	qint64 fileSize;
+	qint64 fileModified;
+	QTimer timer;
+	// Records gathered on the GUI thread since the last flush.
+	QByteArray queued;
+	QString path;
+	std::optional<QLockFile> lock;
+	QThread *writer = nullptr;
+	QMutex mutex;
+	QWaitCondition changed;
+	QByteArray pending;
+	bool closing = false;
+};
+
+EditJournal::EditJournal(QString const &fileName, Units units, QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<EditJournal::Impl>(fileName, units))
+{
+	QObject::connect(&im->timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+EditJournal::~EditJournal()
+{
+	if (im->writer)
+	{
+		{
+			QMutexLocker locker(&im->mutex);
+			im->closing = true;
+			im->pending.clear();
+			im->changed.wakeAll();
+		}
+
+		im->writer->wait();
+		delete im->writer;
+		QFile::remove(im->path);
+	}
+}
+
+EditJournal::Units EditJournal::units() const
+{
+	return im->units;
+}
+
+void EditJournal::record(qint64 position, qint64 removed, QByteArray const &inserted)
+{
+	QDataStream out(&im->queued, QIODeviceBase::Append);
+	out.setVersion(QDataStream::Qt_6_0);
+	out << position << removed << inserted;
+	if (!im->timer.isActive())
+	{
+		im->timer.start();
+	}
+}
+
+std::vector<EditJournal::Orphan> EditJournal::orphans()
+{
+	std::vector<Orphan> found;
+	const QDir dir(journalDir());
+	for (QString const &name : dir.entryList({ "*.journal" }, QDir::Files))
+	{
+		Orphan orphan;
+		orphan.path = dir.filePath(name);
+		orphan.lock = std::make_shared<QLockFile>(orphan.path + ".lock");
+		// The lock of a running editor is never taken over, however long it has been held, while the lock of one
+		// that is gone counts as stale right away.
+		orphan.lock->setStaleLockTime(0);
+		if (!orphan.lock->tryLock(0))
+		{
+			continue;
+		}
+
+		QFile file(orphan.path);
+		if (!file.open(QIODeviceBase::ReadOnly))
+		{
+			continue;
+		}
+
+		QDataStream in(&file);
+		in.setVersion(QDataStream::Qt_6_0);
+		quint32 magic = 0, version = 0;
+		qint32 units = 0;
+		qint64 size = 0, modified = 0;
+		in >> magic >> version >> orphan.fileName >> units >> size >> modified;
+		if (in.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION)
+		{
+			file.close();
+			QFile::remove(orphan.path);
+			continue;
+		}
+
+		orphan.units = units == Bytes ? Bytes : Chars;
+		const QFileInfo info(orphan.fileName);
+		orphan.fileChanged = !orphan.fileName.isEmpty() && (info.size() != size || modifiedTime(info) != modified);
+		// A crash in the middle of a write leaves a partial record at the end, which is dropped.
+		while (!in.atEnd())
+		{
+			Edit edit;
+			in >> edit.position >> edit.removed >> edit.inserted;
+			if (in.status() != QDataStream::Ok)
+			{
+				break;
+			}
+
+			orphan.edits.push_back(std::move(edit));
+		}
+
+		found.push_back(std::move(orphan));
+	}
+
+	return found;
+}
+
+void EditJournal::remove(Orphan const &orphan)
+{
+	QFile::remove(orphan.path);
+	orphan.lock->unlock();
+}
+
+void EditJournal::flush()
+{
+	if (im->queued.isEmpty())
+	{
+		return;
+	}
+
+	if (!im->writer)
+	{
+		im->open();
+		if (!im->writer)
+		{
+			im->queued.clear();
+			return;
+		}
+	}
+
+	QMutexLocker locker(&im->mutex);
+	im->pending.append(im->queued);
+	im->queued.clear();
+	im->changed.wakeAll();
+}
@@ -0,0 +1,87 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** editjournal.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+class QLockFile;
+
+// Keeps the edits made to a document in a journal on disk, so they survive a crash.  Only what changed is written, in
+// batches that a thread of its own appends and syncs a moment after typing, so the cost follows the amount typed and
+// never the size of the document.
+//
+// A journal is held by the process writing it until it is discarded, once its edits are saved or abandoned.  Journals
+// whose process went away are left for the next launch to replay against the file they started from.
+class EditJournal : public QObject
+{
+	Q_OBJECT
+
+public:
+	// Positions and lengths count characters of a document, or bytes of a buffer.
+	enum Units
+	{
+		Chars,
+		Bytes
+	};
+
+	// Replaces removed units at position with the inserted text, held as UTF-8.
+	struct Edit
+	{
+		qint64 position;
+		qint64 removed;
+		QByteArray inserted;
+	};
+
+	// A journal left behind, claimed by this process until it is removed.
+	struct Orphan
+	{
+		QString path;
+		// Empty for a document that was never saved.
+		QString fileName;
+		Units units;
+		// The file was written since the journal started, so its edits no longer line up with it.
+		bool fileChanged;
+		std::vector<Edit> edits;
+		std::shared_ptr<QLockFile> lock;
+	};
+
+	// Journals the edits to fileName as it is on disk now, or to a new document when it is empty.  Nothing is written
+	// before the first edit.
+	EditJournal(QString const &fileName, Units units, QObject *parent = nullptr);
+	// Discards the journal.
+	~EditJournal();
+
+	Units units() const;
+	void record(qint64 position, qint64 removed, QByteArray const &inserted);
+
+	static std::vector<Orphan> orphans();
+	static void remove(Orphan const &orphan);
+
+private slots:
+	void flush();
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
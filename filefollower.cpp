@@ -0,0 +1,228 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** filefollower.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "filefollower.hpp"
+
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QStringDecoder>
+#include <QTimer>
+
+#include <algorithm>
+
+#if defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#endif
+
+#include "textencoding.hpp"
+
+// How long change notifications are gathered before the file is read.
+constexpr int FOLLOW_INTERVAL = 100;
+// How often a file is looked for while there is nothing at its path to watch, as in the middle of a rotation.
+constexpr int POLL_INTERVAL = 1000;
+// Most read in one go, a burst of output is taken in over several intervals rather than stalling the view.
+constexpr qint64 FOLLOW_CHUNK = 4 << 20;
+
+namespace
+{
+// Tells a file that took the place of another one apart from it, where the platform allows.  Elsewhere only a file
+// that shrank is noticed.
+struct FileId
+{
+	quint64 device = 0;
+	quint64 inode = 0;
+
+	bool operator==(FileId const &other) const
+	{
+		return device == other.device && inode == other.inode;
+	}
+};
+
+FileId fileId(QString const &fileName)
+{
+#if defined(Q_OS_UNIX)
+	struct stat info;
+	if (::stat(QFile::encodeName(fileName).constData(), &info) == 0)
+	{
+		return { quint64(info.st_dev), quint64(info.st_ino) };
+	}
+#else
+	Q_UNUSED(fileName)
+#endif
+
+	return {};
+}
+}
+
+struct FileFollower::Impl
+{
+	Impl(QString const &fileName, qint64 offset, TextEncoding const &encoding) :
+	    fileName(fileName),
+	    offset(offset),
+	    encoding(encoding),
+	    id(fileId(fileName))
+	{
+		timer.setSingleShot(true);
+		resetDecoder();
+	}
+
+	// Text picked up in the middle of the file must not lose a leading U+FEFF, which is only a byte order mark at its
+	// very start.
+	void resetDecoder()
+	{
+		held.clear();
+		decoder = offset == 0 ? encoding.decoder()
+		                      : QStringDecoder(encoding.encoding(), QStringConverter::Flag::ConvertInitialBom);
+	}
+
+	// Bytes at the start that make whole characters, less a \r at their end, which waits to see whether a \n follows.
+	qint64 wholeLength(QByteArray const &bytes) const
+	{
+		const qint64 size = bytes.size();
+		if (encoding.encoding() == QStringConverter::Latin1 || encoding.isUtf8())
+		{
+			qint64 length = size;
+			// A lead byte whose sequence runs past the end is held back along with whatever of it was read.
+			for (qint64 i = size - 1; encoding.isUtf8() && i >= 0 && i >= size - 3; --i)
+			{
+				const uchar c = uchar(bytes[i]);
+				if ((c & 0xC0) != 0x80)
+				{
+					length = i + (c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1) > size ? i : size;
+					break;
+				}
+			}
+
+			return length > 0 && bytes[length - 1] == '\r' ? length - 1 : length;
+		}
+
+		// UTF-16 goes by units, and a high surrogate waits for the low one after it.
+		const qint64 high = encoding.encoding() == QStringConverter::Utf16BE ? 0 : 1;
+		qint64 length = size & ~qint64(1);
+		if (length >= 2 && (uchar(bytes[length - 2 + high]) & 0xFC) == 0xD8)
+		{
+			length -= 2;
+		}
+
+		const bool crLast = length >= 2 && bytes[length - 1 - high] == '\r' && bytes[length - 2 + high] == 0;
+		return crLast ? length - 2 : length;
+	}
+
+	QString fileName;
+	// End of what was read, the held bytes included.
+	qint64 offset;
+	TextEncoding encoding;
+	FileId id;
+	QStringDecoder decoder;
+	QByteArray held;
+	bool raw = false;
+	QFileSystemWatcher watcher;
+	QTimer timer;
+};
+
+FileFollower::FileFollower(QString const &fileName, qint64 offset, TextEncoding const &encoding, QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<FileFollower::Impl>(fileName, offset, encoding))
+{
+	QObject::connect(&im->watcher, SIGNAL(fileChanged(QString)), this, SLOT(fileChanged()));
+	QObject::connect(&im->timer, SIGNAL(timeout()), this, SLOT(readNew()));
+	im->watcher.addPath(fileName);
+	// Whatever was added between loading the file and following it is picked up right away.
+	im->timer.start(0);
+}
+
+FileFollower::~FileFollower()
+{
+	// No implementation.
+}
+
+qint64 FileFollower::offset() const
+{
+	return im->offset - im->held.size();
+}
+
+void FileFollower::setRaw(bool raw)
+{
+	im->raw = raw;
+}
+
+void FileFollower::skipTo(qint64 offset)
+{
+	im->offset = offset;
+	im->resetDecoder();
+}
+
+void FileFollower::fileChanged()
+{
+	if (!im->timer.isActive())
+	{
+		im->timer.start(FOLLOW_INTERVAL);
+	}
+}
+
+void FileFollower::readNew()
+{
+	// A file that was removed or renamed is no longer watched, so the path is taken up again once something is there.
+	QFile file(im->fileName);
+	if (!file.open(QIODeviceBase::ReadOnly))
+	{
+		im->timer.start(POLL_INTERVAL);
+		return;
+	}
+
+	if (!im->watcher.files().contains(im->fileName) && !im->watcher.addPath(im->fileName))
+	{
+		im->timer.start(POLL_INTERVAL);
+	}
+
+	const FileId id = fileId(im->fileName);
+	const qint64 size = file.size();
+	if (!(id == im->id) || size < im->offset)
+	{
+		im->id = id;
+		im->offset = 0;
+		im->resetDecoder();
+		emit restarted();
+	}
+
+	// Whoever took in the file again after a restart may have taken in more of it than was there a moment ago.
+	if (size <= im->offset || !file.seek(im->offset))
+	{
+		return;
+	}
+
+	const QByteArray read = file.read(std::min(size - im->offset, FOLLOW_CHUNK));
+	im->offset += read.size();
+	QByteArray bytes = im->held + read;
+	const qint64 whole = im->wholeLength(bytes);
+	im->held = bytes.mid(whole);
+	bytes.truncate(whole);
+	if (im->raw && !bytes.isEmpty())
+	{
+		emit bytesAppended(bytes);
+	}
+	else if (QString text = im->decoder.decode(bytes); !text.isEmpty())
+	{
+		emit appended(text);
+	}
+
+	if (im->offset < size && !im->timer.isActive())
+	{
+		im->timer.start(FOLLOW_INTERVAL);
+	}
+}
@@ -0,0 +1,64 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** filefollower.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QObject>
+
+#include <memory>
+
+class TextEncoding;
+
+// Watches a file that keeps growing, a log most of the time, and reports only what was added to it.  Change
+// notifications are gathered for a moment before the file is read, so however fast it grows the cost per second
+// stays the same.
+//
+// A file that shrinks, or that is replaced by another one at the same path as logs are when they rotate, is followed
+// again from its start.
+class FileFollower : public QObject
+{
+	Q_OBJECT
+
+public:
+	// Follows the file from offset on, where the text already shown ends.
+	FileFollower(QString const &fileName, qint64 offset, TextEncoding const &encoding, QObject *parent = nullptr);
+	~FileFollower();
+
+	// End of what was reported so far.  Bytes that do not make a whole character yet, and a \r that may still be
+	// followed by a \n, are read but held back, so they come after it.
+	qint64 offset() const;
+	// Reports the bytes as they are through bytesAppended() rather than decoding them, for a view that holds the bytes
+	// of the file.
+	void setRaw(bool raw);
+	// Carries on from the given offset, for a view that took the file in again itself after restarted().
+	void skipTo(qint64 offset);
+
+signals:
+	// The file was truncated or replaced, so whatever was read from it before is gone.
+	void restarted();
+	void appended(QString const &text);
+	void bytesAppended(QByteArray const &bytes);
+
+private slots:
+	void fileChanged();
+	void readNew();
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
@@ -0,0 +1,195 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** fileloader.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "fileloader.hpp"
+
+#include <QFile>
+#include <QSemaphore>
+#include <QStringDecoder>
+
+#include <atomic>
+#include <optional>
+
+#include "lineendings.hpp"
+#include "textencoding.hpp"
+
+// The first batch is kept small so the first screen of text shows up as soon as possible.
+constexpr qint64 FIRST_BATCH = 64 << 10;
+constexpr qint64 BATCH_SIZE = 1 << 20;
+// How many decoded batches may wait for the GUI thread before reading pauses.
+constexpr int BATCHES_IN_FLIGHT = 4;
+
+struct FileLoader::Impl
+{
+	Impl(QString const &fileName) :
+	    fileName(fileName),
+	    credits(BATCHES_IN_FLIGHT)
+	{
+		// No implementation.
+	}
+
+	bool waitForCredit()
+	{
+		while (!credits.tryAcquire(1, 50))
+		{
+			if (cancelled)
+			{
+				return false;
+			}
+		}
+
+		return !cancelled;
+	}
+
+	// Checks that a file taken for UTF-8 really is, until it turns out not to be.  As long as everything so far was
+	// ASCII, which decodes the same either way, the file can still move over to Latin-1 without anything being lost.
+	// Returns the bytes left to decode, which after such a move include the partial sequence the UTF-8 decoder held.
+	QByteArray checkUtf8(QByteArray const &bytes, bool atEnd, std::optional<QStringDecoder> &decoder)
+	{
+		const QByteArray checked = partial + bytes;
+		bool truncated = false;
+		const qint64 valid = TextEncoding::validUtf8(checked.constData(), checked.size(), truncated);
+		allAscii = allAscii && TextEncoding::isAscii(checked.constData(), valid);
+		partial.clear();
+		if (valid == checked.size() || (truncated && !atEnd))
+		{
+			partial = checked.mid(valid);
+			return bytes;
+		}
+
+		checking = false;
+		if (!allAscii)
+		{
+			lossy = true;
+			return bytes;
+		}
+
+		encoding = TextEncoding(QStringConverter::Latin1);
+		decoder.emplace(encoding.load().decoder());
+		return checked;
+	}
+
+	QString fileName;
+	QSemaphore credits;
+	std::atomic<bool> cancelled { false };
+	std::atomic<TextEncoding> encoding;
+	std::atomic<bool> lossy { false };
+	LineEndings endings;
+	QByteArray partial;
+	bool checking = false;
+	bool allAscii = true;
+};
+
+FileLoader::FileLoader(QString const &fileName, QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<FileLoader::Impl>(fileName))
+{
+	// No implementation.
+}
+
+FileLoader::~FileLoader()
+{
+	// No implementation.
+}
+
+void FileLoader::cancel()
+{
+	im->cancelled = true;
+}
+
+void FileLoader::batchConsumed()
+{
+	im->credits.release();
+}
+
+TextEncoding FileLoader::encoding() const
+{
+	return im->encoding;
+}
+
+bool FileLoader::isLossy() const
+{
+	return im->lossy;
+}
+
+LineEndings FileLoader::lineEndings() const
+{
+	return im->endings;
+}
+
+void FileLoader::run()
+{
+	QFile file(im->fileName);
+	if (!file.open(QIODeviceBase::ReadOnly))
+	{
+		emit failed();
+		return;
+	}
+
+	const qint64 total = file.size();
+	std::optional<QStringDecoder> decoder;
+	qint64 done = 0;
+	qint64 batch = FIRST_BATCH;
+	QString carry;
+	while (!file.atEnd())
+	{
+		QByteArray bytes = file.read(batch);
+		if (bytes.isEmpty())
+		{
+			emit failed();
+			return;
+		}
+
+		if (!decoder)
+		{
+			const TextEncoding detected = TextEncoding::detect(bytes.constData(), bytes.size(), file.atEnd());
+			im->encoding = detected;
+			im->checking = detected.isUtf8();
+			decoder.emplace(detected.decoder());
+		}
+
+		batch = BATCH_SIZE;
+		done += bytes.size();
+		if (im->checking)
+		{
+			bytes = im->checkUtf8(bytes, file.atEnd(), decoder);
+		}
+
+		const QString decoded = decoder->decode(bytes);
+		im->endings.count(decoded);
+		QString text = carry + decoded;
+		carry.clear();
+		// A \r\n split across two batches would otherwise be inserted as two separate line breaks.
+		if (!file.atEnd() && text.endsWith(QChar('\r')))
+		{
+			carry = text.right(1);
+			text.chop(1);
+		}
+
+		if (!im->waitForCredit())
+		{
+			return;
+		}
+
+		emit batchReady(text);
+		emit progress(done, total);
+	}
+
+	im->endings.finish();
+	emit finished();
+}
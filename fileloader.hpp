@@ -0,0 +1,59 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** fileloader.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QObject>
+
+#include <memory>
+
+class LineEndings;
+class TextEncoding;
+
+class FileLoader : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit FileLoader(QString const &fileName, QObject *parent = nullptr);
+	~FileLoader();
+
+	// Both of these may be called from any thread.
+	void cancel();
+	void batchConsumed();
+	// Settled by the time the first batch is ready, though it may still fall back to Latin-1 later on.
+	TextEncoding encoding() const;
+	// Whether invalid UTF-8 turned up after other text that was not ASCII, so the file kept being decoded as UTF-8 and
+	// saving it would write replacement characters in place of those bytes.
+	bool isLossy() const;
+	// Only complete once finished() has been emitted.
+	LineEndings lineEndings() const;
+
+signals:
+	void batchReady(QString const &text);
+	void progress(qint64 done, qint64 total);
+	void finished();
+	void failed();
+
+public slots:
+	void run();
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
@@ -0,0 +1,252 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** filesaver.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "filesaver.hpp"
+
+#include <QSaveFile>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <optional>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+#include "textbuffer.hpp"
+
+// How many chunks may wait to be written before push() starts refusing more.
+constexpr size_t CHUNKS_IN_FLIGHT = 8;
+
+struct FileSaver::Impl
+{
+	Impl(QString const &fileName) :
+	    file(fileName)
+	{
+		// No implementation.
+	}
+
+	bool writeQueued(QSaveFile &file)
+	{
+		forever
+		{
+			QByteArray chunk;
+			{
+				QMutexLocker lock(&mutex);
+				while (queue.empty() && !closed)
+				{
+					changed.wait(&mutex);
+				}
+
+				if (queue.empty())
+				{
+					return !cancelled;
+				}
+
+				chunk = std::move(queue.front());
+				queue.pop_front();
+				changed.wakeAll();
+			}
+
+			if (file.write(chunk) != chunk.size())
+			{
+				// Keep the writer side from blocking on a queue nobody is draining anymore.
+				QMutexLocker lock(&mutex);
+				closed = true;
+				queue.clear();
+				changed.wakeAll();
+				return false;
+			}
+		}
+	}
+
+	// A single pass over the pieces of the buffer, with a \r that ends one piece waiting for what starts the next.
+	bool writeConverted(QSaveFile &file)
+	{
+		QByteArray out;
+		bool pendingCr = false;
+		const bool written = buffer->forEachChunk(0, buffer->size(), [&](const char *data, qint64 length) {
+			out.clear();
+			const char *end = data + length;
+			for (const char *at = data; at < end;)
+			{
+				if (pendingCr)
+				{
+					pendingCr = false;
+					out += lineBreak;
+					at += *at == '\n' ? 1 : 0;
+					continue;
+				}
+
+				const char *stop = std::find_if(at, end, [](char c) { return c == '\n' || c == '\r'; });
+				out.append(at, stop - at);
+				if (stop < end)
+				{
+					if (*stop == '\r')
+					{
+						pendingCr = true;
+					}
+					else
+					{
+						out += lineBreak;
+					}
+
+					++stop;
+				}
+
+				at = stop;
+			}
+
+			return file.write(out) == out.size();
+		});
+
+		return written && (!pendingCr || file.write(lineBreak) == lineBreak.size());
+	}
+
+	bool syncToDisk(QSaveFile &file)
+	{
+		if (!file.flush())
+		{
+			return false;
+		}
+
+#if defined(Q_OS_UNIX)
+		return ::fsync(file.handle()) == 0;
+#elif defined(Q_OS_WIN)
+		return ::_commit(file.handle()) == 0;
+#else
+		return true;
+#endif
+	}
+
+	// Made on the thread that creates the saver, which is the one to commit it.
+	QSaveFile file;
+	std::optional<TextBuffer> buffer;
+	QByteArray lineBreak;
+	QMutex mutex;
+	QWaitCondition changed;
+	std::deque<QByteArray> queue;
+	bool closed = false;
+	bool cancelled = false;
+	std::atomic<bool> ok { false };
+};
+
+FileSaver::FileSaver(QString const &fileName, QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<FileSaver::Impl>(fileName))
+{
+	// No implementation.
+}
+
+FileSaver::~FileSaver()
+{
+	// No implementation.
+}
+
+void FileSaver::setBuffer(TextBuffer const &snapshot)
+{
+	im->buffer = snapshot;
+}
+
+void FileSaver::setLineBreak(QByteArray const &lineBreak)
+{
+	im->lineBreak = lineBreak;
+}
+
+bool FileSaver::push(QByteArray const &chunk, bool wait)
+{
+	QMutexLocker lock(&im->mutex);
+	while (im->queue.size() >= CHUNKS_IN_FLIGHT && !im->closed)
+	{
+		if (!wait)
+		{
+			return false;
+		}
+
+		im->changed.wait(&im->mutex);
+	}
+
+	if (!im->closed)
+	{
+		im->queue.push_back(chunk);
+		im->changed.wakeAll();
+	}
+
+	return true;
+}
+
+void FileSaver::close()
+{
+	QMutexLocker lock(&im->mutex);
+	im->closed = true;
+	im->changed.wakeAll();
+}
+
+void FileSaver::cancel()
+{
+	QMutexLocker lock(&im->mutex);
+	im->closed = true;
+	im->cancelled = true;
+	im->queue.clear();
+	im->changed.wakeAll();
+}
+
+bool FileSaver::succeeded() const
+{
+	return im->ok;
+}
+
+bool FileSaver::commit()
+{
+	return im->ok && im->file.commit();
+}
+
+void FileSaver::run()
+{
+	// QSaveFile writes next to the target and renames over it on commit, so the original is intact until the very end.
+	QSaveFile &file = im->file;
+	bool written = file.open(QIODeviceBase::WriteOnly);
+	if (written)
+	{
+		if (!im->buffer)
+		{
+			written = im->writeQueued(file);
+		}
+		else
+		{
+			written = im->lineBreak.isEmpty() ? im->buffer->writeTo(file) : im->writeConverted(file);
+		}
+	}
+
+	if (written && im->syncToDisk(file))
+	{
+		im->ok = true;
+	}
+	else
+	{
+		file.cancelWriting();
+		close();
+	}
+
+	emit finished();
+}
@@ -0,0 +1,59 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** filesaver.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QObject>
+
+#include <memory>
+
+class TextBuffer;
+
+class FileSaver : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit FileSaver(QString const &fileName, QObject *parent = nullptr);
+	~FileSaver();
+
+	// Saves a snapshot of the buffer, otherwise the content is streamed in through push() until close() is called.
+	void setBuffer(TextBuffer const &snapshot);
+	// Rewrites every line break of the snapshot as the given one on the way out.
+	void setLineBreak(QByteArray const &lineBreak);
+
+	// These may be called from any thread.  Without waiting, push() refuses the chunk while the queue is full.
+	bool push(QByteArray const &chunk, bool wait = false);
+	void close();
+	// Gives up on the streamed content, the file is left as it was.
+	void cancel();
+	// Whether everything was written, which only takes the place of the file once commit() is called after
+	// finished(), on the thread that owns the file.
+	bool succeeded() const;
+	bool commit();
+
+signals:
+	void finished();
+
+public slots:
+	void run();
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
@@ -34,9 +34,14 @@ struct FindReplaceDialog::Impl
 		ui.setupUi(top);
 		focusFind(true);
 		ui.notFoundLabel->setVisible(false);
+		ui.matchCountLabel->setVisible(false);
 		notFoundCooldown.setSingleShot(true);
 		notFoundCooldown.setInterval(5000);
 		QObject::connect(&notFoundCooldown, SIGNAL(timeout()), top, SLOT(silenceNotFound()));
+		// Waits for a pause in typing, so a burst of keystrokes only searches once.
+		searchDelay.setSingleShot(true);
+		searchDelay.setInterval(150);
+		QObject::connect(&searchDelay, SIGNAL(timeout()), top, SLOT(searchAsYouType()));
 	}
 
 	void focusFind(bool findOrReplace)
@@ -65,6 +70,7 @@ struct FindReplaceDialog::Impl
 	Ui::FindReplaceDialog ui;
 	QLineEdit *focusedEdit;
 	QTimer notFoundCooldown;
+	QTimer searchDelay;
 };
 
 FindReplaceDialog::FindReplaceDialog(QWidget *parent) :
@@ -93,6 +99,15 @@ void FindReplaceDialog::findFieldChanged(QString const &newText)
 {
 	im->ui.findNextButton->setDisabled(newText.isEmpty());
 	im->testReplaceButtons(im->ui.replaceLineEdit->text());
+	emit incrementalSearchCancelled();
+	if (newText.isEmpty())
+	{
+		im->searchDelay.stop();
+	}
+	else
+	{
+		im->searchDelay.start();
+	}
 }
 
 void FindReplaceDialog::replaceFieldChanged(QString const &newText)
@@ -126,6 +141,20 @@ void FindReplaceDialog::reportNoFind()
 	im->notFoundCooldown.start();
 }
 
+void FindReplaceDialog::reportMatchCount(int current, int total)
+{
+	if (total < 0)
+	{
+		im->ui.matchCountLabel->setVisible(false);
+		return;
+	}
+
+	//: Position of the selected match among all matches of the search.
+	im->ui.matchCountLabel->setText(current > 0 ? tr("%1 of %2").arg(current).arg(total)
+	                                            : tr("%n match(es)", "", total));
+	im->ui.matchCountLabel->setVisible(true);
+}
+
 void FindReplaceDialog::doSwap()
 {
 	QString oldFindContent = im->ui.findLineEdit->text();
@@ -138,6 +167,11 @@ void FindReplaceDialog::silenceNotFound()
 	im->ui.notFoundLabel->setVisible(false);
 }
 
+void FindReplaceDialog::searchAsYouType()
+{
+	emit incrementalSearchRequested(im->flags(), im->ui.findLineEdit->text());
+}
+
 void FindReplaceDialog::backReplace()
 {
 	emit replaceRequested(im->flags(false, true), im->ui.findLineEdit->text(), im->ui.replaceLineEdit->text());
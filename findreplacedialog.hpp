@@ -39,6 +39,8 @@ signals:
 	void findRequested(FindFlags flags, QString const &seek);
 	void replaceRequested(FindFlags flags, QString const &seek, QString const &replace);
 	void replaceAllRequested(FindFlags flags, QString const &seek, QString const &replace);
+	void incrementalSearchRequested(FindFlags flags, QString const &seek);
+	void incrementalSearchCancelled();
 
 public slots:
 	void findFieldChanged(QString const &newText);
@@ -51,10 +53,12 @@ public slots:
 	void replaceAllPressed();
 
 	void reportNoFind();
+	void reportMatchCount(int current, int total);
 	void doSwap();
 
 private slots:
 	void silenceNotFound();
+	void searchAsYouType();
 
 	void backReplace();
 	void modReplace();
@@ -0,0 +1,153 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** instanceserver.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "instanceserver.hpp"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+// How long a new instance waits on a running one before starting up by itself after all.
+constexpr int FORWARD_TIMEOUT = 500;
+
+namespace
+{
+// One server per user, since users sharing a machine must never end up in each other's editor.
+QString serverName()
+{
+	return QCoreApplication::applicationName().remove(' ') + '-'
+	       + QString::number(qHash(QDir::homePath()), 16);
+}
+}
+
+struct InstanceServer::Impl
+{
+	Impl(InstanceServer *top) :
+	    server(top)
+	{
+		server.setSocketOptions(QLocalServer::UserAccessOption);
+		QObject::connect(&server, SIGNAL(newConnection()), top, SLOT(newConnection()));
+	}
+
+	QLocalServer server;
+};
+
+InstanceServer::InstanceServer(QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<InstanceServer::Impl>(this))
+{
+	// No implementation.
+}
+
+InstanceServer::~InstanceServer()
+{
+	// No implementation.
+}
+
+bool InstanceServer::forward(QStringList const &files)
+{
+	QLocalSocket socket;
+	socket.connectToServer(serverName());
+	if (!socket.waitForConnected(FORWARD_TIMEOUT))
+	{
+		return false;
+	}
+
+	// The running instance has a working directory of its own, so relative paths have to be resolved here.
+	QStringList absolute;
+	for (QString const &file : files)
+	{
+		absolute.append(QFileInfo(file).absoluteFilePath());
+	}
+
+	QByteArray message;
+	QDataStream out(&message, QIODeviceBase::WriteOnly);
+	out << absolute;
+	socket.write(message);
+	while (socket.bytesToWrite() > 0)
+	{
+		if (!socket.waitForBytesWritten(FORWARD_TIMEOUT))
+		{
+			return false;
+		}
+	}
+
+	socket.disconnectFromServer();
+	return true;
+}
+
+bool InstanceServer::listen()
+{
+	if (im->server.listen(serverName()))
+	{
+		return true;
+	}
+
+	if (im->server.serverError() != QAbstractSocket::AddressInUseError)
+	{
+		return false;
+	}
+
+	// The socket is only taken over when connecting to it is refused outright, which means it was left behind by an
+	// instance that did not shut down cleanly.  One that is merely slow to answer is still running.
+	QLocalSocket probe;
+	probe.connectToServer(serverName());
+	if (probe.waitForConnected(FORWARD_TIMEOUT))
+	{
+		probe.disconnectFromServer();
+		return false;
+	}
+
+	if (probe.error() != QLocalSocket::ServerNotFoundError && probe.error() != QLocalSocket::ConnectionRefusedError)
+	{
+		return false;
+	}
+
+	QLocalServer::removeServer(serverName());
+	return im->server.listen(serverName());
+}
+
+void InstanceServer::newConnection()
+{
+	while (QLocalSocket *socket = im->server.nextPendingConnection())
+	{
+		QObject::connect(socket, SIGNAL(readyRead()), this, SLOT(readFiles()));
+		QObject::connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+	}
+}
+
+void InstanceServer::readFiles()
+{
+	QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+	if (!socket)
+	{
+		return;
+	}
+
+	QDataStream in(socket);
+	in.startTransaction();
+	QStringList files;
+	in >> files;
+	if (in.commitTransaction())
+	{
+		emit filesReceived(files);
+	}
+}
@@ -0,0 +1,51 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** instanceserver.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+
+#include <memory>
+
+// Keeps the editor to a single process per user.  The first instance listens on a local socket, and later ones hand
+// their files over to it and exit instead of starting up a whole new copy of Qt.
+class InstanceServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit InstanceServer(QObject *parent = nullptr);
+	~InstanceServer();
+
+	// Sends the files to a running instance, returns false when there is none to take them.
+	static bool forward(QStringList const &files);
+	bool listen();
+
+signals:
+	// An empty list asks for an empty window.
+	void filesReceived(QStringList const &files);
+
+private slots:
+	void newConnection();
+	void readFiles();
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
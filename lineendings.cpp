@@ -0,0 +1,178 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** lineendings.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "lineendings.hpp"
+
+#include <QtAlgorithms>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LINEENDINGS_SSE2
+#endif
+
+namespace
+{
+#ifdef LINEENDINGS_SSE2
+// Masks of the \n and \r among the sixteen units at the given position.
+void breakMasks(const char *at, unsigned &lfMask, unsigned &crMask)
+{
+	const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+	lfMask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+	crMask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+}
+
+void breakMasks(const char16_t *at, unsigned &lfMask, unsigned &crMask)
+{
+	const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+	const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at + 8));
+	const __m128i lf = _mm_set1_epi16('\n');
+	const __m128i cr = _mm_set1_epi16('\r');
+	// Packing the two halves of a comparison gives one byte, and so one bit of the mask, per unit.
+	lfMask = unsigned(_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(low, lf), _mm_cmpeq_epi16(high, lf))));
+	crMask = unsigned(_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(low, cr), _mm_cmpeq_epi16(high, cr))));
+}
+#endif
+}
+
+void LineEndings::count(const char *begin, const char *end)
+{
+	countUnits(begin, end);
+}
+
+void LineEndings::count(QStringView text)
+{
+	const char16_t *units = reinterpret_cast<const char16_t *>(text.utf16());
+	countUnits(units, units + text.size());
+}
+
+void LineEndings::finish()
+{
+	if (pendingCr)
+	{
+		++crs;
+		pendingCr = false;
+	}
+}
+
+qint64 LineEndings::lf() const
+{
+	return lfs;
+}
+
+qint64 LineEndings::crLf() const
+{
+	return crLfs;
+}
+
+qint64 LineEndings::cr() const
+{
+	return crs;
+}
+
+bool LineEndings::isMixed() const
+{
+	return (lfs != 0) + (crLfs != 0) + (crs != 0) > 1;
+}
+
+LineEndings::Style LineEndings::style() const
+{
+	if (crLfs > lfs && crLfs >= crs)
+	{
+		return CrLf;
+	}
+
+	return crs > lfs && crs > crLfs ? Cr : Lf;
+}
+
+LineEndings LineEndings::convertedTo(Style style) const
+{
+	LineEndings converted;
+	const qint64 total = lfs + crLfs + crs;
+	(style == Lf ? converted.lfs : style == CrLf ? converted.crLfs : converted.crs) = total;
+	return converted;
+}
+
+QString LineEndings::breakText(Style style)
+{
+	return style == CrLf ? QStringLiteral("\r\n") : style == Cr ? QStringLiteral("\r") : QStringLiteral("\n");
+}
+
+QByteArray LineEndings::breakBytes(Style style)
+{
+	return style == CrLf ? QByteArrayLiteral("\r\n") : style == Cr ? QByteArrayLiteral("\r") : QByteArrayLiteral("\n");
+}
+
+template<typename Char>
+void LineEndings::countUnits(const Char *begin, const Char *end)
+{
+	const Char *at = begin;
+	if (pendingCr && at < end)
+	{
+		pendingCr = false;
+		if (*at == '\n')
+		{
+			++crLfs;
+			++at;
+		}
+		else
+		{
+			++crs;
+		}
+	}
+
+#ifdef LINEENDINGS_SSE2
+	// The unit after each block is looked at too, to pair a \r at its very end, so there always has to be one.
+	while (end - at > 16)
+	{
+		unsigned lfMask, crMask;
+		breakMasks(at, lfMask, crMask);
+		const unsigned pairs = crMask & ((lfMask >> 1) | (at[16] == '\n' ? 0x8000u : 0u));
+		const qint64 paired = qPopulationCount(pairs);
+		crLfs += paired;
+		crs += qPopulationCount(crMask) - paired;
+		// The \n of a pair is not a break of its own, and one that completes a pair past the end of the block is
+		// skipped over.
+		lfs += qPopulationCount(lfMask) - qPopulationCount(pairs & 0x7FFFu);
+		at += (pairs & 0x8000u) ? 17 : 16;
+	}
+#endif
+
+	for (; at < end; ++at)
+	{
+		if (*at == '\n')
+		{
+			++lfs;
+		}
+		else if (*at == '\r')
+		{
+			if (at + 1 == end)
+			{
+				pendingCr = true;
+			}
+			else if (at[1] == '\n')
+			{
+				++crLfs;
+				++at;
+			}
+			else
+			{
+				++crs;
+			}
+		}
+	}
+}
@@ -0,0 +1,61 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** lineendings.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Line breaks of a file counted by style, so it can be written back the way it was read.
+class LineEndings
+{
+public:
+	enum Style
+	{
+		Lf,
+		CrLf,
+		Cr
+	};
+
+	// Counts text that arrives in pieces, a \r that ends one piece pairs with a \n that starts the next.
+	void count(const char *begin, const char *end);
+	void count(QStringView text);
+	// Settles a \r that ended the last piece.
+	void finish();
+
+	qint64 lf() const;
+	qint64 crLf() const;
+	qint64 cr() const;
+	bool isMixed() const;
+	// The most common style, LF when there are no breaks at all.
+	Style style() const;
+	// The same breaks, all of them in the given style.
+	LineEndings convertedTo(Style style) const;
+
+	static QString breakText(Style style);
+	static QByteArray breakBytes(Style style);
+
+private:
+	template<typename Char>
+	void countUnits(const Char *begin, const Char *end);
+
+	qint64 lfs = 0;
+	qint64 crLfs = 0;
+	qint64 crs = 0;
+	bool pendingCr = false;
+};
@@ -0,0 +1,151 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** lineindex.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "lineindex.hpp"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LINEINDEX_SSE2
+#endif
+
+#include "mappedfile.hpp"
+
+// Bytes per block of the index, which is also the most that has to be scanned at either end of a lookup.
+constexpr qint64 INDEX_BLOCK = 64 << 10;
+
+std::shared_ptr<LineIndex const> LineIndex::build(std::shared_ptr<MappedFile> file, std::atomic<bool> const *cancel)
+{
+	std::shared_ptr<LineIndex> index(new LineIndex(std::move(file)));
+	const char *data = index->file->data();
+	const qint64 size = index->file->size();
+	index->blockBreaks.reserve(size_t(size / INDEX_BLOCK + 2));
+	index->blockBreaks.push_back(0);
+	for (qint64 start = 0; start < size; start += INDEX_BLOCK)
+	{
+		if (cancel && cancel->load())
+		{
+			return nullptr;
+		}
+
+		const qint64 end = std::min(size, start + INDEX_BLOCK);
+		index->blockBreaks.push_back(index->blockBreaks.back() + countBreaks(data + start, data + end, data + size));
+		index->endings.count(data + start, data + end);
+	}
+
+	index->endings.finish();
+	return index;
+}
+
+qint64 LineIndex::countBreaks(const char *begin, const char *end, const char *limit)
+{
+	qint64 count = 0;
+	const char *at = begin;
+#ifdef LINEINDEX_SSE2
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	// Every \n and every \r is a break, less each \r that is followed by a \n.
+	for (; end - at >= 16; at += 16)
+	{
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+		const unsigned lfs = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(block, lf)));
+		const unsigned crs = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(block, cr)));
+		if ((lfs | crs) == 0)
+		{
+			continue;
+		}
+
+		const bool lfNext = at + 16 < limit && at[16] == '\n';
+		const unsigned pairs = crs & ((lfs >> 1) | (lfNext ? 0x8000u : 0u));
+		count += qPopulationCount(lfs) + qPopulationCount(crs) - qPopulationCount(pairs);
+	}
+#endif
+
+	for (; at < end; ++at)
+	{
+		if (*at == '\n' || (*at == '\r' && (at + 1 == limit || at[1] != '\n')))
+		{
+			++count;
+		}
+	}
+
+	return count;
+}
+
+qint64 LineIndex::findBreak(const char *begin, const char *end, const char *limit, qint64 count)
+{
+	if (count <= 0)
+	{
+		return 0;
+	}
+
+	for (const char *at = begin; at < end; ++at)
+	{
+		if ((*at == '\n' || (*at == '\r' && (at + 1 == limit || at[1] != '\n'))) && --count == 0)
+		{
+			return at + 1 - begin;
+		}
+	}
+
+	return -1;
+}
+
+qint64 LineIndex::breaks(qint64 from, qint64 to) const
+{
+	return to <= from ? 0 : breaksBefore(to) - breaksBefore(from);
+}
+
+qint64 LineIndex::lineStart(qint64 line) const
+{
+	line = std::min(line, blockBreaks.back());
+	if (line <= 0)
+	{
+		return 0;
+	}
+
+	// The block holding the line'th break is the last one starting with fewer breaks before it.
+	const auto found = std::lower_bound(blockBreaks.begin(), blockBreaks.end(), line);
+	const qint64 block = qint64(found - blockBreaks.begin()) - 1;
+	const char *data = file->data();
+	const qint64 start = block * INDEX_BLOCK;
+	const qint64 end = std::min(file->size(), start + INDEX_BLOCK);
+	return start + findBreak(data + start, data + end, data + file->size(), line - blockBreaks[size_t(block)]);
+}
+
+LineEndings const &LineIndex::lineEndings() const
+{
+	return endings;
+}
+
+LineIndex::LineIndex(std::shared_ptr<MappedFile> file) :
+    file(std::move(file))
+{
+	// No implementation.
+}
+
+qint64 LineIndex::breaksBefore(qint64 offset) const
+{
+	offset = std::clamp<qint64>(offset, 0, file->size());
+	const qint64 block = offset / INDEX_BLOCK;
+	const qint64 start = block * INDEX_BLOCK;
+	const char *data = file->data();
+	return blockBreaks[size_t(block)] + countBreaks(data + start, data + offset, data + file->size());
+}
@@ -0,0 +1,62 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** lineindex.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "lineendings.hpp"
+
+class MappedFile;
+
+// Line breaks of a mapped file, counted once per fixed size block so the breaks within any range of the file, or where
+// any line starts, are found with a binary search over the blocks and a scan of at most two of them.
+//
+// A break is \n, \r\n or a lone \r, and it sits on its last byte, so a \r\n pair is never counted twice however a
+// range cuts through it.
+class LineIndex
+{
+public:
+	// Scans the whole file, which takes a while for a big one.  Returns null once cancel is set.
+	static std::shared_ptr<LineIndex const> build(std::shared_ptr<MappedFile> file, std::atomic<bool> const *cancel);
+
+	// Breaks whose last byte lies in [begin, end).  A \r at end - 1 is one only when the byte at end, if it is before
+	// limit, is not a \n.
+	static qint64 countBreaks(const char *begin, const char *end, const char *limit);
+	// Offset from begin just past the count'th break, or -1 when there are fewer breaks than that before end.
+	static qint64 findBreak(const char *begin, const char *end, const char *limit, qint64 count);
+
+	qint64 breaks(qint64 from, qint64 to) const;
+	// Offset of the start of the given zero based line of the file, clamped to the last line.
+	qint64 lineStart(qint64 line) const;
+	LineEndings const &lineEndings() const;
+
+private:
+	explicit LineIndex(std::shared_ptr<MappedFile> file);
+
+	qint64 breaksBefore(qint64 offset) const;
+
+	std::shared_ptr<MappedFile> file;
+	// Breaks before the start of each block, with one more entry for the end of the file.
+	std::vector<qint64> blockBreaks;
+	LineEndings endings;
+};
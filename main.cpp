@@ -22,17 +22,71 @@
 
 #include <QApplication>
 #include <QLocale>
+#include <QTextStream>
 #include <QTranslator>
 #include <QCommandLineOption>
 #include <QCommandLineParser>
 
+#include "batchreplace.hpp"
 #include "buildinfo.hpp"
+#include "instanceserver.hpp"
+#include "startuptrace.hpp"
+#include "undohistory.hpp"
 
 QCommandLineOption localeOp()
 {
 	return { "locale", QApplication::tr("Set the translation locale file to use.", "Core"), "code" };
 }
 
+QCommandLineOption newInstanceOp()
+{
+	return { "new-instance", QApplication::tr("Run in a process of its own, even if the editor is already running.",
+	                                          "Core") };
+}
+
+QCommandLineOption startupTraceOp()
+{
+	return { "startup-trace", QApplication::tr("Report how long each step of starting up takes.", "Core") };
+}
+
+QCommandLineOption undoMemoryOp()
+{
+	return { "undo-memory", QApplication::tr("Keep at most this many megabytes of undo history in each window.",
+	                                         "Core"), "megabytes" };
+}
+
+QCommandLineOption findOp()
+{
+	return { "find", QApplication::tr("Find the text in the files given and report how often it matches, without "
+	                                  "opening a window.", "Core"), "text" };
+}
+
+QCommandLineOption replaceOp()
+{
+	return { "replace", QApplication::tr("Replace what --find matches with the text.", "Core"), "text" };
+}
+
+QCommandLineOption regexOp()
+{
+	return { "regex", QApplication::tr("Take the text to find for a regular expression.", "Core") };
+}
+
+QCommandLineOption caseSensitiveOp()
+{
+	return { "case-sensitive", QApplication::tr("Match case when finding.", "Core") };
+}
+
+QCommandLineOption wholeWordsOp()
+{
+	return { "whole-words", QApplication::tr("Match whole words only when finding.", "Core") };
+}
+
+QCommandLineOption inPlaceOp()
+{
+	return { "in-place", QApplication::tr("Write the replacements back to the files, rather than only counting them.",
+	                                      "Core") };
+}
+
 void setupParser(QCommandLineParser &parser)
 {
 	parser.addPositionalArgument(QApplication::tr("files", "Core"),
@@ -44,13 +98,20 @@ void setupParser(QCommandLineParser &parser)
 	            QApplication::tr("The Simple Qt Text Editor is a clone of Windows Notepad for all major platforms.",
 	                             "Core"));
 	parser.addOption(localeOp());
+	parser.addOption(newInstanceOp());
+	parser.addOption(startupTraceOp());
+	parser.addOption(undoMemoryOp());
+	parser.addOption(findOp());
+	parser.addOption(replaceOp());
+	parser.addOption(regexOp());
+	parser.addOption(caseSensitiveOp());
+	parser.addOption(wholeWordsOp());
+	parser.addOption(inPlaceOp());
 }
 
-int main(int argc, char *argv[])
+void setupApplication(QCoreApplication &a, QTranslator &translator)
 {
-	QApplication a(argc, argv);
 	const QStringList args = a.arguments();
-	QTranslator translator;
 	QStringList uiLanguages = QLocale::system().uiLanguages();
 	if (auto localeLoc = std::find(args.begin(), args.end(), "--locale");
 	    localeLoc != args.end() && ++localeLoc != args.end())
@@ -74,10 +135,113 @@ int main(int argc, char *argv[])
 	a.setApplicationVersion(versionString());
 	a.setOrganizationName(QApplication::tr("KirHut Software Company", "Core"));
 	a.setOrganizationDomain(QApplication::tr("kirhut.com", "Core"));
+}
+
+// Finding and replacing from the command line has to work without a display, so it is decided before a QApplication
+// would try to connect to one.
+bool isBatch(int argc, char *argv[])
+{
+	return std::any_of(argv + 1, argv + argc, [](const char *arg) {
+		return qstrcmp(arg, "--find") == 0 || qstrncmp(arg, "--find=", 7) == 0;
+	});
+}
+
+int batchError(QString const &message)
+{
+	QTextStream(stderr) << message << Qt::endl;
+	return 2;
+}
+
+int runBatch(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QTranslator translator;
+	setupApplication(a, translator);
+	QCommandLineParser parser;
+	setupParser(parser);
+	parser.process(a.arguments());
+	const QStringList files = parser.positionalArguments();
+	if (files.isEmpty())
+	{
+		return batchError(QApplication::tr("No files given to search.", "Core"));
+	}
+
+	if (parser.isSet(inPlaceOp()) && !parser.isSet(replaceOp()))
+	{
+		return batchError(QApplication::tr("--in-place needs --replace.", "Core"));
+	}
+
+	FindFlags flags = FFlags::None;
+	flags |= parser.isSet(regexOp()) ? FFlags::FindByRegex : FFlags::None;
+	flags |= parser.isSet(caseSensitiveOp()) ? FFlags::FindCaseSensitively : FFlags::None;
+	flags |= parser.isSet(wholeWordsOp()) ? FFlags::FindWholeWords : FFlags::None;
+	BatchReplace batch(flags, parser.value(findOp()));
+	if (!batch.isValid())
+	{
+		return batchError(QApplication::tr("The text to find is not a valid regular expression.", "Core"));
+	}
+
+	if (parser.isSet(replaceOp()))
+	{
+		batch.setReplacement(parser.value(replaceOp()), parser.isSet(inPlaceOp()));
+	}
+
+	return batch.run(files);
+}
+
+int main(int argc, char *argv[])
+{
+	if (isBatch(argc, argv))
+	{
+		return runBatch(argc, argv);
+	}
+
+	// Tracing has to start before anything else does, long before the parser has seen the command line.
+	StartupTrace trace(std::any_of(argv + 1, argv + argc,
+	                               [](const char *arg) { return qstrcmp(arg, "--startup-trace") == 0; }));
+	QApplication a(argc, argv);
+	trace.mark("application");
+	QTranslator translator;
+	setupApplication(a, translator);
+	trace.mark("translators");
 	QCommandLineParser parser;
 	setupParser(parser);
-	parser.process(args);
+	parser.process(a.arguments());
+	const QStringList files = parser.positionalArguments();
+	const bool newInstance = parser.isSet(newInstanceOp());
+	if (!newInstance && InstanceServer::forward(files))
+	{
+		return 0;
+	}
+
+	bool ok = false;
+	if (const qint64 megabytes = parser.value(undoMemoryOp()).toLongLong(&ok); ok && megabytes >= 0)
+	{
+		UndoHistory::setDefaultBudget(megabytes << 20);
+	}
+
+	trace.mark("command line");
 	MainWindow w;
+	trace.mark("setupUi");
 	w.show();
+	trace.markFirstPaint();
+	InstanceServer server;
+	QObject::connect(&server, SIGNAL(filesReceived(QStringList)), &w, SLOT(openFiles(QStringList)));
+	if (!newInstance)
+	{
+		server.listen();
+	}
+
+	// Every file gets a window of its own, and since each one loads on its own thread they all load at once.
+	if (!files.isEmpty())
+	{
+		w.loadFile(files.first());
+		if (files.size() > 1)
+		{
+			w.openFiles(files.mid(1));
+		}
+	}
+
+	w.recoverEdits();
 	return a.exec();
 }
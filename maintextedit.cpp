@@ -18,11 +18,1237 @@
 ***********************************************************************************************************************/
 #include "maintextedit.hpp"
 
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QSignalBlocker>
+#include <QKeyEvent>
+#include <QInputMethodEvent>
+#include <QContextMenuEvent>
+#include <QDropEvent>
+#include <QMenu>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "lineindex.hpp"
+#include "textbuffer.hpp"
+#include "syntaxhighlighter.hpp"
+#include "undohistory.hpp"
+
+// Number of lines held in the document while a buffer is shown, unless the viewport needs more.
+constexpr int WINDOW_LINES = 2000;
+// Lines kept loaded above the top of the viewport, so scrolling up does not immediately shift the window.
+constexpr int WINDOW_LEAD = 500;
+// Once the viewport comes this close to either edge of the window, the window is moved.
+constexpr int WINDOW_MARGIN = 100;
+// Upper bound on the bytes decoded into a single window, regardless of how many lines that covers.
+constexpr qint64 WINDOW_BYTES = 4 << 20;
+// Step used when scanning backwards through the buffer for the start of a line.
+constexpr qint64 SCAN_STEP = 64 << 10;
+// Lines longer than this are shown as segments of about this many bytes, each a block of its own, so the document
+// never has to lay out more than that in one piece.  Segments start at multiples of it in the buffer, which makes where
+// a line is cut independent of where the window starts.
+constexpr qint64 SEGMENT_BYTES = 16 << 10;
+// The line number gutter is always wide enough for this many digits, plus padding on either side.
+constexpr int GUTTER_DIGITS = 3;
+constexpr int GUTTER_PADDING = 4;
+// Milliseconds of layout done in the background before the event loop gets a turn.
+constexpr int LAYOUT_SLICE = 8;
+// Characters kept on either side of the cursor before a key is handled, as much as deleting a word could take out.
+constexpr int CAPTURE_CHARS = 64 << 10;
+
+namespace
+{
+// Bytes needed to store the given text as UTF-8.
+qint64 utf8Length(QStringView text)
+{
+	qint64 length = 0;
+	for (QChar c : text)
+	{
+		const char16_t unit = c.unicode();
+		length += unit < 0x80 ? 1 : unit < 0x800 || c.isSurrogate() ? 2 : 3;
+	}
+
+	return length;
+}
+
+bool isBreak(char c)
+{
+	return c == '\n' || c == '\r';
+}
+
+bool isContinuation(char c)
+{
+	return (uchar(c) & 0xC0) == 0x80;
+}
+
+// Length of the UTF-8 sequence at data, or 0 if the bytes there are not a valid one: a stray continuation byte, a
+// sequence cut short, an overlong form, a surrogate or a code point past U+10FFFF.
+int sequenceLength(const char *data, const char *end)
+{
+	const uchar lead = uchar(*data);
+	if (lead < 0x80)
+	{
+		return 1;
+	}
+
+	const int length = lead >= 0xC2 && lead <= 0xDF ? 2 : (lead & 0xF0) == 0xE0 ? 3
+	                   : lead >= 0xF0 && lead <= 0xF4 ? 4 : 0;
+	if (length == 0 || end - data < length || !std::all_of(data + 1, data + length, isContinuation))
+	{
+		return 0;
+	}
+
+	const uchar second = uchar(data[1]);
+	if ((lead == 0xE0 && second < 0xA0) || (lead == 0xED && second >= 0xA0) || (lead == 0xF0 && second < 0x90)
+	    || (lead == 0xF4 && second >= 0x90))
+	{
+		return 0;
+	}
+
+	return length;
+}
+
+// Decodes like QString::fromUtf8, except that every byte outside of a valid sequence becomes a replacement character of
+// its own.  That way each character of the window stands for a known run of bytes, one for a byte that was invalid.
+QString decodeUtf8(const char *data, qint64 length)
+{
+	QString text;
+	const char *end = data + length;
+	const char *run = data;
+	for (const char *at = data; at < end;)
+	{
+		const int sequence = sequenceLength(at, end);
+		if (sequence > 0)
+		{
+			at += sequence;
+			continue;
+		}
+
+		text += QString::fromUtf8(run, at - run);
+		text += QChar(QChar::ReplacementCharacter);
+		run = ++at;
+	}
+
+	text += QString::fromUtf8(run, end - run);
+	return text;
+}
+
+// Characters of the window, in UTF-16 units, of the sequences from data that start before stop, and how many bytes from
+// data it takes to make up the given number of units.  Bytes up to end are only read to finish a sequence.
+qint64 unitsOf(const char *data, const char *stop, const char *end)
+{
+	qint64 units = 0;
+	for (const char *at = data; at < stop;)
+	{
+		const int sequence = std::max(1, sequenceLength(at, end));
+		units += sequence == 4 ? 2 : 1;
+		at += sequence;
+	}
+
+	return units;
+}
+
+qint64 bytesOfUnits(const char *data, const char *end, qint64 units)
+{
+	const char *at = data;
+	for (qint64 done = 0; done < units && at < end; ++done)
+	{
+		const int sequence = std::max(1, sequenceLength(at, end));
+		done += sequence == 4 ? 1 : 0;
+		at += sequence;
+	}
+
+	return at - data;
+}
+
+qint64 alignUp(qint64 offset)
+{
+	return (offset + SEGMENT_BYTES - 1) / SEGMENT_BYTES * SEGMENT_BYTES;
+}
+
+// The range a document reports for an edit can repeat unchanged text, which is dropped from either end of the old and
+// new text alike.
+void trimCommon(int &position, QString &removed, QString &inserted)
+{
+	qsizetype prefix = 0;
+	while (prefix < inserted.size() && prefix < removed.size() && inserted[prefix] == removed[prefix])
+	{
+		++prefix;
+	}
+
+	qsizetype suffix = 0;
+	while (suffix < inserted.size() - prefix && suffix < removed.size() - prefix
+	       && inserted[inserted.size() - 1 - suffix] == removed[removed.size() - 1 - suffix])
+	{
+		++suffix;
+	}
+
+	inserted = inserted.mid(prefix, inserted.size() - prefix - suffix);
+	removed = removed.mid(prefix, removed.size() - prefix - suffix);
+	position += int(prefix);
+}
+
+QString textOf(QTextCursor const &cursor)
+{
+	return cursor.selectedText().replace(QChar::ParagraphSeparator, QChar('\n'));
+}
+
+bool mayEdit(QKeyEvent *e)
+{
+	return !e->text().isEmpty() || e->key() == Qt::Key_Backspace || e->key() == Qt::Key_Delete;
+}
+}
+
+struct MainTextEdit::Impl
+{
+	// Where a block of the window starts, both in the buffer and in the document.  A block continuing a line split
+	// into segments follows a break that is only in the document.
+	struct WindowLine
+	{
+		qint64 byte;
+		int chr;
+		bool continued;
+	};
+
+	Impl(MainTextEdit *top) :
+	    top(top),
+	    offsetBar(new QScrollBar(Qt::Vertical, top)),
+	    gutter(new QWidget(top)),
+	    highlighter(top->document())
+	{
+		// The document would keep a copy of everything an edit takes out, for as long as it lives.
+		top->document()->setUndoRedoEnabled(false);
+		offsetBar->hide();
+		gutter->installEventFilter(top);
+		QObject::connect(top, SIGNAL(updateRequest(QRect,int)), top, SLOT(viewUpdated(QRect,int)));
+		QObject::connect(top, SIGNAL(blockCountChanged(int)), top, SLOT(updateMargins()));
+		QObject::connect(offsetBar, SIGNAL(valueChanged(int)), top, SLOT(offsetBarMoved(int)));
+		QObject::connect(top->verticalScrollBar(), SIGNAL(valueChanged(int)), top, SLOT(viewScrolled()));
+		QObject::connect(top->document(), SIGNAL(contentsChange(int,int,int)),
+		                 top,             SLOT(documentEdited(int,int,int)));
+		QObject::connect(top->document(), SIGNAL(modificationChanged(bool)), top, SLOT(modificationChanged(bool)));
+		layoutTimer.setSingleShot(true);
+		layoutTimer.setInterval(0);
+		QObject::connect(&layoutTimer, SIGNAL(timeout()), top, SLOT(layoutSlice()));
+	}
+
+	qint64 size() const
+	{
+		return buffer->size();
+	}
+
+	qint64 lastBreakBefore(qint64 offset, qint64 limit) const
+	{
+		while (offset > limit)
+		{
+			const qint64 from = std::max(limit, offset - SCAN_STEP);
+			const QByteArray block = buffer->read(from, offset - from);
+			for (qint64 i = block.size() - 1; i >= 0; --i)
+			{
+				if (isBreak(block[i]))
+				{
+					return from + i;
+				}
+			}
+
+			offset = from;
+		}
+
+		return -1;
+	}
+
+	// Where the segment cut at the given multiple of SEGMENT_BYTES starts, or -1 if a line ends right there and
+	// leaves nothing to cut.  A cut never falls on the continuation bytes of a UTF-8 sequence, it moves back to the
+	// first byte of it.
+	qint64 segmentCut(qint64 aligned) const
+	{
+		const QByteArray around = buffer->read(aligned - 3, 4);
+		if (around.size() < 4 || isBreak(around[3]))
+		{
+			return -1;
+		}
+
+		qint64 cut = aligned;
+		for (int i = 3; i > 0 && isContinuation(around[i]); --i)
+		{
+			--cut;
+		}
+
+		return cut;
+	}
+
+	// Start of the block holding the byte at offset.  Line ends are \n, \r\n or a lone \r, which is exactly how
+	// QTextDocument splits text into blocks, and a line goes on into a new segment at every multiple of SEGMENT_BYTES
+	// that is a whole segment past its start.  Finding either never means looking further back than two segments.
+	qint64 segmentStartBefore(qint64 offset) const
+	{
+		const qint64 aligned = offset / SEGMENT_BYTES * SEGMENT_BYTES;
+		const qint64 limit = std::max<qint64>(0, aligned - SEGMENT_BYTES);
+		const qint64 i = lastBreakBefore(offset, limit);
+		if (i >= 0 && i + 1 == offset && offset < size() && buffer->read(i, 2) == "\r\n")
+		{
+			// The offset is the \n of a \r\n pair, which still belongs to the line that pair terminates.
+			return segmentStartBefore(i);
+		}
+
+		qint64 start = i + 1;
+		qint64 next = alignUp(start + SEGMENT_BYTES);
+		if (i < 0 && limit > 0)
+		{
+			// The line starts a whole segment before the multiple below the offset, so a segment starts there, unless
+			// the offset is a break sitting right on it.
+			start = segmentCut(aligned);
+			if (start < 0)
+			{
+				return segmentStartBefore(aligned - 1);
+			}
+
+			next = aligned + SEGMENT_BYTES;
+		}
+
+		// The next cut can still hold the offset when it moves back over a character.
+		for (qint64 cut = segmentCut(next); cut >= 0 && cut <= offset; cut = segmentCut(next))
+		{
+			start = cut;
+			next += SEGMENT_BYTES;
+		}
+
+		return start;
+	}
+
+	int visibleLines() const
+	{
+		return std::max(1, top->viewport()->height() / QFontMetrics(top->document()->defaultFont()).lineSpacing());
+	}
+
+	QString buildWindow(qint64 start)
+	{
+		const size_t maxLines = size_t(std::max(WINDOW_LINES, visibleLines() * 4));
+		// One extra byte is read so a \r\n pair at the end of the block is never mistaken for a lone \r.
+		const QByteArray bytes = buffer->read(start, WINDOW_BYTES + 1);
+		const bool toEnd = start + bytes.size() == size();
+		const qint64 available = bytes.size() - (toEnd ? 0 : 1);
+		bool continued = start > 0 && !isBreak(buffer->read(start - 1, 1).at(0));
+		QString text;
+		qint64 pos = 0, contentEnd = 0;
+		lines.clear();
+		// No block is longer than two segments, so the window always holds at least one of them.
+		forever
+		{
+			// Where the block has to be cut if its line does not end first.
+			const qint64 at = start + pos;
+			const qint64 split = (continued ? alignUp(at) + SEGMENT_BYTES : alignUp(at + SEGMENT_BYTES)) - start;
+			qint64 i = pos;
+			while (i < available && i < split && !isBreak(bytes[i]))
+			{
+				++i;
+			}
+
+			if (i >= available && !toEnd)
+			{
+				break;
+			}
+
+			const bool cut = i == split && i < available && !isBreak(bytes[i]);
+			qint64 end = i;
+			for (int back = 0; cut && back < 3 && isContinuation(bytes[end]); ++back)
+			{
+				--end;
+			}
+
+			if (!lines.empty())
+			{
+				text += QChar('\n');
+			}
+
+			lines.push_back({ start + pos, int(text.size()), continued });
+			text += decodeUtf8(bytes.constData() + pos, end - pos);
+			contentEnd = end;
+			if (i >= available || lines.size() >= maxLines)
+			{
+				break;
+			}
+
+			continued = cut;
+			pos = cut ? end : (bytes[i] == '\r' && i + 1 < bytes.size() && bytes[i + 1] == '\n') ? i + 2 : i + 1;
+		}
+
+		windowStart = start;
+		windowEnd = start + contentEnd;
+		return text;
+	}
+
+	int lineForChar(int position) const
+	{
+		auto found = std::upper_bound(lines.begin(), lines.end(), position,
+		                              [](int pos, WindowLine const &line) { return pos < line.chr; });
+		return std::max(0, int(found - lines.begin()) - 1);
+	}
+
+	int lineForByte(qint64 offset) const
+	{
+		auto found = std::upper_bound(lines.begin(), lines.end(), offset,
+		                              [](qint64 off, WindowLine const &line) { return off < line.byte; });
+		return std::max(0, int(found - lines.begin()) - 1);
+	}
+
+	// The mirror can not tell a replacement character that was typed from one standing for an invalid byte, so the
+	// way between characters and bytes goes over the bytes of the buffer, which the mirror was decoded from.
+	qint64 byteOf(int position) const
+	{
+		const WindowLine line = lines[lineForChar(position)];
+		const qint64 units = position - line.chr;
+		// A character is never more than three bytes a unit, and one more sequence is read so the last is never cut.
+		const QByteArray bytes = buffer->read(line.byte, units * 3 + 3);
+		return line.byte + bytesOfUnits(bytes.constData(), bytes.constData() + bytes.size(), units);
+	}
+
+	int charOf(qint64 offset) const
+	{
+		const WindowLine line = lines[lineForByte(offset)];
+		const QByteArray bytes = buffer->read(line.byte, offset - line.byte + 3);
+		const char *data = bytes.constData();
+		const char *stop = data + std::min<qint64>(offset - line.byte, bytes.size());
+		const qint64 units = unitsOf(data, stop, data + bytes.size());
+		return int(std::min<qint64>(line.chr + units, mirror.size()));
+	}
+
+	void loadWindow(qint64 topLine, bool syncBar)
+	{
+		qint64 cursorLine = -1;
+		int cursorCol = 0;
+		if (!lines.empty())
+		{
+			QTextCursor current = top->textCursor();
+			cursorLine = lines[std::min(size_t(current.blockNumber()), lines.size() - 1)].byte;
+			cursorCol = current.positionInBlock();
+		}
+
+		qint64 start = topLine;
+		for (int i = 0; i < WINDOW_LEAD && start > 0; ++i)
+		{
+			start = segmentStartBefore(start - 1);
+		}
+
+		updating = true;
+		mirror = buildWindow(start);
+		top->setPlainText(mirror);
+		top->document()->setModified(modified);
+
+		QTextDocument *doc = top->document();
+		if (cursorLine >= windowStart && cursorLine <= windowEnd)
+		{
+			QTextBlock block = doc->findBlockByNumber(lineForByte(cursorLine));
+			QTextCursor restored(block);
+			restored.setPosition(block.position() + std::min(cursorCol, block.length() - 1));
+			top->setTextCursor(restored);
+		}
+		else
+		{
+			top->setTextCursor(QTextCursor(doc->findBlockByNumber(lineForByte(topLine))));
+		}
+
+		top->verticalScrollBar()->setValue(doc->findBlockByNumber(lineForByte(topLine)).firstLineNumber());
+		updating = false;
+
+		const qint64 avgLine = std::max<qint64>(1, (windowEnd - windowStart) / qint64(lines.size()));
+		offsetBar->setSingleStep(int(std::max<qint64>(1, avgLine >> barShift)));
+		offsetBar->setPageStep(int(std::max<qint64>(1, (avgLine * visibleLines()) >> barShift)));
+		if (syncBar)
+		{
+			syncOffsetBar(topLine);
+		}
+	}
+
+	void loadEnd()
+	{
+		qint64 topLine = segmentStartBefore(size());
+		for (int i = visibleLines(); i > 1 && topLine > 0; --i)
+		{
+			topLine = segmentStartBefore(topLine - 1);
+		}
+
+		loadWindow(topLine, false);
+		top->verticalScrollBar()->setValue(top->verticalScrollBar()->maximum());
+		syncOffsetBar(size());
+	}
+
+	void updateBarRange()
+	{
+		barShift = 0;
+		while ((size() >> barShift) > std::numeric_limits<int>::max() / 2)
+		{
+			++barShift;
+		}
+
+		QSignalBlocker blocker(offsetBar);
+		offsetBar->setRange(0, int(size() >> barShift));
+	}
+
+	void syncOffsetBar(qint64 offset)
+	{
+		QSignalBlocker blocker(offsetBar);
+		offsetBar->setValue(offset >= size() ? offsetBar->maximum() : int(offset >> barShift));
+	}
+
+	void placeOffsetBar()
+	{
+		const QRect cr = top->contentsRect();
+		const int width = offsetBar->sizeHint().width();
+		offsetBar->setGeometry(QRect(cr.right() - width + 1, cr.top(), width, top->viewport()->height()));
+	}
+
+	void highlightShown()
+	{
+		const int first = top->firstVisibleBlock().blockNumber();
+		highlighter.showBlocks(first, first + visibleLines());
+	}
+
+	void placeGutter()
+	{
+		const QRect cr = top->contentsRect();
+		gutter->setGeometry(QRect(cr.left(), cr.top(), top->viewportMargins().left(), top->viewport()->height()));
+	}
+
+	int gutterWidth() const
+	{
+		int digits = 1;
+		for (qint64 count = top->lineCount(); count >= 10; count /= 10)
+		{
+			++digits;
+		}
+
+		const int digitWidth = QFontMetrics(top->document()->defaultFont()).horizontalAdvance(QLatin1Char('9'));
+		return GUTTER_PADDING * 2 + digitWidth * std::max(digits, GUTTER_DIGITS);
+	}
+
+	// Line of the buffer shown by the first block of the document, or -1 while that is not known yet.
+	qint64 firstLine() const
+	{
+		if (!buffer)
+		{
+			return 0;
+		}
+
+		return buffer->hasLineIndex() && !lines.empty() ? buffer->lineAt(windowStart) : -1;
+	}
+
+	bool continues(int block) const
+	{
+		return block >= 0 && size_t(block) < lines.size() && lines[block].continued;
+	}
+
+	// Lines starting in the blocks after the first up to the given one, which is every one of them without a buffer.
+	qint64 linesBefore(int block) const
+	{
+		if (lines.empty())
+		{
+			return block;
+		}
+
+		const auto end = lines.begin() + std::min(size_t(block), lines.size() - 1) + 1;
+		return std::count_if(lines.begin() + 1, end, [](WindowLine const &line) { return !line.continued; });
+	}
+
+	// UTF-16 units of the bytes in [from, to).
+	qint64 unitsBetween(qint64 from, qint64 to) const
+	{
+		qint64 count = 0;
+		buffer->forEachChunk(from, to, [&count](const char *data, qint64 length) {
+			// Every character has one byte that is not a continuation, and a second unit past the BMP.
+			for (qint64 i = 0; i < length; ++i)
+			{
+				count += (isContinuation(data[i]) ? 0 : 1) + (uchar(data[i]) >= 0xF0 ? 1 : 0);
+			}
+
+			return true;
+		});
+		return count;
+	}
+
+	// Characters of the first line of the window that come before it, or -1 while the lines are still being counted.
+	// Counting them can mean reading far back, so the count is kept, and as long as the window stays on the same line
+	// only what it moved over is counted.
+	qint64 windowColumn()
+	{
+		if (!buffer->hasLineIndex())
+		{
+			return -1;
+		}
+
+		const qint64 lineStart = buffer->lineStart(buffer->lineAt(windowStart));
+		if (columnFor < 0 || columnLine != lineStart)
+		{
+			columnLine = lineStart;
+			columnFor = lineStart;
+			columnChars = 0;
+		}
+
+		if (windowStart >= columnFor)
+		{
+			columnChars += unitsBetween(columnFor, windowStart);
+		}
+		else
+		{
+			columnChars -= unitsBetween(windowStart, columnFor);
+		}
+
+		columnFor = windowStart;
+		return columnChars;
+	}
+
+	// An edit from the given offset on leaves the bytes counted before it as they were.
+	void columnEdited(qint64 position)
+	{
+		if (position < columnFor)
+		{
+			columnFor = -1;
+		}
+	}
+
+	// Counting the lines of the whole file means reading all of it, so it is left to a thread of its own and the
+	// gutter stays blank until it is done.
+	void startIndexing()
+	{
+		stopIndexing();
+		fileEndings.reset();
+		if (buffer->hasLineIndex())
+		{
+			return;
+		}
+
+		std::shared_ptr<MappedFile> file = buffer->original();
+		indexCancel = false;
+		indexThread = QThread::create([this, file]() { indexed = LineIndex::build(file, &indexCancel); });
+		QObject::connect(indexThread, SIGNAL(finished()), top, SLOT(linesIndexed()));
+		indexThread->start(QThread::LowPriority);
+	}
+
+	void stopIndexing()
+	{
+		if (indexThread)
+		{
+			indexCancel = true;
+			indexThread->wait();
+			delete indexThread;
+			indexThread = nullptr;
+		}
+	}
+
+	// Qt only lays out the blocks the view paints, every other block counts as a single line of no width until then,
+	// which leaves the scrollbars a guess.  The rest of the document is laid out in slices, from the view downwards
+	// and then from the top, until the guesses are all replaced.  With wrapping on, a quick pass first guesses how
+	// many lines each block wraps into from its length, which brings the scrollbar close long before it is exact.
+	void startLayout()
+	{
+		estimating = top->lineWrapMode() != QPlainTextEdit::NoWrap;
+		layoutNext = estimating ? 0 : top->firstVisibleBlock().blockNumber();
+		layoutLeft = top->document()->blockCount();
+		layoutTimer.start();
+	}
+
+	int estimateLines(QTextBlock const &block, qreal charWidth, qreal lineWidth) const
+	{
+		return std::max(1, int(std::ceil(block.length() * charWidth / lineWidth)));
+	}
+
+	// Mirrors a change of the document into the buffer, and keeps the window's line table in step with it.
+	void applyEdit(int position, QString const &removed, QString const &inserted)
+	{
+		const qint64 byteStart = byteOf(position);
+		const qint64 byteEnd = byteOf(position + int(removed.size()));
+		QString stored = inserted;
+		const QByteArray encoded = stored.replace(QChar('\n'), lineBreak).toUtf8();
+		std::vector<TextBuffer::Extent> taken;
+		if (undoEnabled)
+		{
+			taken = buffer->extents(byteStart, byteEnd - byteStart);
+		}
+
+		buffer->remove(byteStart, byteEnd - byteStart);
+		buffer->insert(byteStart, encoded);
+		columnEdited(byteStart);
+		emit top->bufferEdited(byteStart, byteEnd - byteStart, encoded);
+		if (undoEnabled)
+		{
+			history.record(byteStart, encoded.size(), std::move(taken), typing);
+			historyChanged();
+		}
+
+		const int first = lineForChar(position);
+		const int last = lineForChar(position + int(removed.size()));
+		const int charDelta = int(inserted.size() - removed.size());
+		const qint64 byteDelta = encoded.size() - (byteEnd - byteStart);
+		lines.erase(lines.begin() + first + 1, lines.begin() + last + 1);
+		for (auto line = lines.begin() + first + 1; line != lines.end(); ++line)
+		{
+			line->byte += byteDelta;
+			line->chr += charDelta;
+		}
+
+		std::vector<WindowLine> added;
+		qint64 bytes = byteStart;
+		for (int i = 0; i < inserted.size(); ++i)
+		{
+			const bool isLineBreak = inserted[i] == QChar('\n');
+			bytes += isLineBreak ? lineBreak.size() : utf8Length(QStringView(inserted).mid(i, 1));
+			if (isLineBreak)
+			{
+				added.push_back({ bytes, position + i + 1, false });
+			}
+		}
+
+		lines.insert(lines.begin() + first + 1, added.begin(), added.end());
+		mirror.replace(position, removed.size(), inserted);
+		windowEnd += byteDelta;
+	}
+
+	// Top of a window with the given offset about halfway down the viewport.
+	qint64 centredOn(qint64 offset) const
+	{
+		qint64 topLine = segmentStartBefore(offset);
+		for (int i = visibleLines() / 2; i > 0 && topLine > 0; --i)
+		{
+			topLine = segmentStartBefore(topLine - 1);
+		}
+
+		return topLine;
+	}
+
+	// Keeps the text from a line before the selection of cursor to a line after it, which covers whatever a key can
+	// take out next to the cursor as well.  Events nest, the outermost one takes the text and lets go of it again.
+	void capture(QTextCursor const &cursor)
+	{
+		if (captureDepth++ == 0)
+		{
+			take(cursor);
+		}
+	}
+
+	void release()
+	{
+		if (--captureDepth == 0)
+		{
+			captured.clear();
+			capturedAt = -1;
+		}
+	}
+
+	void take(QTextCursor const &cursor)
+	{
+		captured.clear();
+		capturedAt = -1;
+		if (buffer || !undoEnabled || top->isReadOnly())
+		{
+			return;
+		}
+
+		QTextDocument *doc = top->document();
+		const QTextBlock first = doc->findBlock(cursor.selectionStart());
+		const QTextBlock last = doc->findBlock(cursor.selectionEnd());
+		const int from = std::max({ 0, first.position() - 1, cursor.selectionStart() - CAPTURE_CHARS });
+		const int to = std::min({ doc->characterCount() - 1, last.position() + last.length(),
+		                          cursor.selectionEnd() + CAPTURE_CHARS });
+		QTextCursor range(doc);
+		range.setPosition(from);
+		range.setPosition(std::max(from, to), QTextCursor::KeepAnchor);
+		captured = textOf(range);
+		capturedAt = from;
+	}
+
+	// Records an edit of the document, whose text taken out has to have been captured before it was made.  Text only
+	// added is read back from the document, but an edit that took out text not captured is one the history can not
+	// undo, and everything before it is forgotten.
+	void recordEdit(int position, int charsRemoved, int charsAdded)
+	{
+		QTextDocument *doc = top->document();
+		const int chars = doc->characterCount();
+		charsRemoved = std::clamp(charsRemoved, 0, std::max(0, documentChars - 1 - position));
+		charsAdded = std::clamp(charsAdded, 0, std::max(0, chars - 1 - position));
+		documentChars = chars;
+		const bool covered = charsRemoved == 0
+		                     || (capturedAt >= 0 && position >= capturedAt
+		                         && position + charsRemoved <= capturedAt + captured.size());
+		QString removed = covered && charsRemoved > 0 ? captured.mid(position - capturedAt, charsRemoved) : QString();
+		captured.clear();
+		capturedAt = -1;
+		if (!undoEnabled || replaying || (charsRemoved == 0 && charsAdded == 0))
+		{
+			return;
+		}
+
+		if (!covered)
+		{
+#ifndef QT_NO_DEBUG
+			qWarning("MainTextEdit: %d characters were taken out at %d without prepareEdit(), undo is forgotten",
+			         charsRemoved, position);
+#endif
+			forget();
+			return;
+		}
+
+		QTextCursor span(doc);
+		span.setPosition(position);
+		span.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+		QString inserted = textOf(span);
+		trimCommon(position, removed, inserted);
+		if (!removed.isEmpty() || !inserted.isEmpty())
+		{
+			history.record(position, inserted.size(), removed, typing);
+			historyChanged();
+		}
+	}
+
+	void forget()
+	{
+		history.clear();
+		if (!top->document()->isModified())
+		{
+			history.markClean();
+		}
+
+		historyChanged();
+	}
+
+	void historyChanged()
+	{
+		emit top->undoAvailable(history.canUndo());
+		emit top->redoAvailable(history.canRedo());
+	}
+
+	// Puts back what the step took out in place of what it left, returning the step that reverts that again.
+	UndoHistory::Step replay(UndoHistory::Step const &step)
+	{
+		if (buffer)
+		{
+			return replayBuffer(step);
+		}
+
+		QTextDocument *doc = top->document();
+		const int last = doc->characterCount() - 1;
+		QTextCursor range(doc);
+		range.setPosition(int(std::min<qint64>(step.position, last)));
+		range.setPosition(int(std::min<qint64>(step.position + step.length, last)), QTextCursor::KeepAnchor);
+		UndoHistory::Step reverse{ step.position, step.text.size(), textOf(range), {} };
+		replaying = true;
+		range.insertText(step.text);
+		replaying = false;
+		top->setTextCursor(range);
+		return reverse;
+	}
+
+	// The text of a buffer goes back by its runs, the window is loaded again over it, and the view only moves if the
+	// edit is above it or past the window.
+	UndoHistory::Step replayBuffer(UndoHistory::Step const &step)
+	{
+		qint64 length = 0;
+		for (TextBuffer::Extent const &run : step.runs)
+		{
+			length += run.length;
+		}
+
+		std::vector<TextBuffer::Extent> taken = buffer->extents(step.position, step.length);
+		buffer->remove(step.position, step.length);
+		buffer->insert(step.position, step.runs);
+		emit top->bufferEdited(step.position, step.length, buffer->read(step.position, length));
+		reloadAfter(step.position, step.position + length);
+		return { step.position, length, QString(), std::move(taken) };
+	}
+
+	// Loads the window again after the buffer was edited from position on, with the cursor at the given offset.
+	void reloadAfter(qint64 position, qint64 cursor)
+	{
+		columnEdited(position);
+		qint64 topLine = lines.empty() ? 0 : lines[std::min(size_t(top->firstVisibleBlock().blockNumber()),
+		                                                    lines.size() - 1)].byte;
+		topLine = position < topLine || position > windowEnd ? centredOn(position) : segmentStartBefore(topLine);
+		updateBarRange();
+		loadWindow(topLine, true);
+		top->setTextCursor(top->selectionAt(cursor, 0));
+		top->updateMargins();
+		gutter->update();
+	}
+
+	// Undoing or redoing back to the saved text makes the document unmodified again.
+	void replayed()
+	{
+		top->document()->setModified(!history.isClean());
+		historyChanged();
+	}
+
+	MainTextEdit *top;
+	QScrollBar *offsetBar;
+	QWidget *gutter;
+	SyntaxHighlighter highlighter;
+	UndoHistory history;
+	// Text of the document around an edit about to be made, taken beforehand since the document only reports what
+	// changed after the fact.  A buffer has the mirror of its window for that.
+	QString captured;
+	int capturedAt = -1;
+	int captureDepth = 0;
+	// Length of the document as of the last edit, which bounds how far the range of the next one can reach.
+	int documentChars = 1;
+	bool undoEnabled = true;
+	bool replaying = false;
+	// The edit being made is a key typed, which adds to the step of the keys before it.
+	bool typing = false;
+	std::shared_ptr<TextBuffer> buffer;
+	QThread *indexThread = nullptr;
+	std::atomic<bool> indexCancel = false;
+	std::shared_ptr<LineIndex const> indexed;
+	std::optional<LineEndings> fileEndings;
+	QString lineBreak = QStringLiteral("\n");
+	std::vector<WindowLine> lines;
+	// The text of the window as last seen, needed because the document only reports what changed after the fact.
+	QString mirror;
+	qint64 windowStart = 0;
+	qint64 windowEnd = 0;
+	// Start of the line the column count was taken on, and the offset it was counted up to.
+	qint64 columnLine = -1;
+	qint64 columnFor = -1;
+	qint64 columnChars = 0;
+	int barShift = 0;
+	int threshold = 0;
+	bool updating = false;
+	bool shiftPending = false;
+	bool modified = false;
+	QTimer layoutTimer;
+	// Block the background layout goes on with, and how many blocks it has still to go.
+	int layoutNext = 0;
+	int layoutLeft = 0;
+	bool estimating = false;
+};
+
 MainTextEdit::MainTextEdit(QWidget *parent) :
     QPlainTextEdit(parent),
-    threshold(0)
+    im(std::make_unique<MainTextEdit::Impl>(this))
+{
+	updateMargins();
+}
+
+MainTextEdit::~MainTextEdit()
+{
+	im->stopIndexing();
+}
+
+bool MainTextEdit::isWindowed() const
+{
+	return bool(im->buffer);
+}
+
+void MainTextEdit::openBuffer(std::shared_ptr<TextBuffer> buffer, bool keepView)
+{
+	qint64 topOffset = 0;
+	if (keepView && im->buffer && !im->lines.empty())
+	{
+		topOffset = im->lines[std::min(size_t(firstVisibleBlock().blockNumber()), im->lines.size() - 1)].byte;
+	}
+
+	im->buffer = std::move(buffer);
+	im->lines.clear();
+	im->columnFor = -1;
+	im->modified = false;
+	im->updateBarRange();
+	im->startIndexing();
+	setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+	im->offsetBar->show();
+	updateMargins();
+	im->placeOffsetBar();
+	im->loadWindow(im->segmentStartBefore(std::min(topOffset, im->size())), true);
+	// Runs of another buffer mean nothing in this one.
+	im->forget();
+}
+
+void MainTextEdit::closeBuffer()
+{
+	if (im->buffer)
+	{
+		im->stopIndexing();
+		im->buffer.reset();
+		im->lines.clear();
+		im->mirror.clear();
+		im->offsetBar->hide();
+		updateMargins();
+		setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+		im->documentChars = document()->characterCount();
+		im->forget();
+	}
+}
+
+void MainTextEdit::appendToBuffer(QByteArray const &bytes)
+{
+	if (!im->buffer || bytes.isEmpty())
+	{
+		return;
+	}
+
+	const bool atEnd = im->windowEnd == im->size() && verticalScrollBar()->value() == verticalScrollBar()->maximum();
+	im->buffer->insert(im->size(), bytes);
+	im->updateBarRange();
+	if (atEnd)
+	{
+		im->loadEnd();
+	}
+}
+
+void MainTextEdit::scrollToEnd()
+{
+	if (im->buffer)
+	{
+		im->loadEnd();
+	}
+	else
+	{
+		verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+	}
+}
+
+void MainTextEdit::pauseIndexing()
+{
+	im->stopIndexing();
+}
+
+void MainTextEdit::resumeIndexing()
+{
+	if (im->buffer && !im->buffer->hasLineIndex() && !im->indexThread)
+	{
+		im->startIndexing();
+	}
+}
+
+std::shared_ptr<TextBuffer> MainTextEdit::buffer() const
+{
+	return im->buffer;
+}
+
+qint64 MainTextEdit::cursorOffset() const
+{
+	if (!im->buffer || im->lines.empty())
+	{
+		return textCursor().position();
+	}
+
+	return im->byteOf(textCursor().position());
+}
+
+qint64 MainTextEdit::offsetOf(int position) const
+{
+	if (!im->buffer || im->lines.empty())
+	{
+		return position;
+	}
+
+	return im->byteOf(position);
+}
+
+QTextCursor MainTextEdit::selectionAt(qint64 offset, qint64 length)
+{
+	if (im->buffer && (im->lines.empty() || offset < im->windowStart || offset + length > im->windowEnd))
+	{
+		// Bring the window over the selection, with the line holding it about halfway down the viewport.
+		im->loadWindow(im->centredOn(offset), true);
+	}
+
+	QTextCursor select(document());
+	if (!im->buffer || im->lines.empty())
+	{
+		select.setPosition(int(offset));
+		select.setPosition(int(offset + length), QTextCursor::KeepAnchor);
+	}
+	else
+	{
+		select.setPosition(im->charOf(offset));
+		select.setPosition(im->charOf(offset + length), QTextCursor::KeepAnchor);
+	}
+
+	return select;
+}
+
+qint64 MainTextEdit::cursorLine() const
+{
+	const qint64 first = im->firstLine();
+	return first < 0 ? -1 : first + im->linesBefore(textCursor().blockNumber());
+}
+
+qint64 MainTextEdit::cursorColumn() const
+{
+	const QTextCursor cursor = textCursor();
+	qint64 column = cursor.positionInBlock();
+	if (!im->buffer || im->lines.empty())
+	{
+		return column;
+	}
+
+	// Every segment of the line before the cursor's adds its length, less the break that is only in the document.
+	int block = std::min(cursor.blockNumber(), int(im->lines.size()) - 1);
+	for (; block > 0 && im->continues(block); --block)
+	{
+		column += im->lines[block].chr - 1 - im->lines[block - 1].chr;
+	}
+
+	if (im->continues(block))
+	{
+		const qint64 before = im->windowColumn();
+		return before < 0 ? -1 : column + before;
+	}
+
+	return column;
+}
+
+qint64 MainTextEdit::lineCount() const
+{
+	if (!im->buffer)
+	{
+		return document()->blockCount();
+	}
+
+	return im->buffer->hasLineIndex() ? im->buffer->lineBreaks() + 1 : -1;
+}
+
+void MainTextEdit::goToLine(qint64 line)
+{
+	if (!im->buffer)
+	{
+		const int block = int(std::clamp<qint64>(line, 0, document()->blockCount() - 1));
+		setTextCursor(QTextCursor(document()->findBlockByNumber(block)));
+	}
+	else if (im->buffer->hasLineIndex())
+	{
+		setTextCursor(selectionAt(im->buffer->lineStart(std::max<qint64>(0, line)), 0));
+	}
+}
+
+void MainTextEdit::setLineBreak(QString const &lineBreak)
+{
+	im->lineBreak = lineBreak;
+}
+
+std::optional<LineEndings> MainTextEdit::lineEndings() const
+{
+	return im->fileEndings;
+}
+
+bool MainTextEdit::eventFilter(QObject *watched, QEvent *event)
+{
+	if (watched == im->gutter && event->type() == QEvent::Paint)
+	{
+		paintGutter(static_cast<QPaintEvent *>(event));
+		return true;
+	}
+
+	return QPlainTextEdit::eventFilter(watched, event);
+}
+
+void MainTextEdit::setDocumentFont(QFont const &font)
+{
+	// Nothing but the look of the text changes, so whatever follows the edits of the document need not hear about it.
+	// The layout is told directly and drops the lines of every block, the view lays out again only what it paints.
+	{
+		const QSignalBlocker blocker(document());
+		document()->setDefaultFont(font);
+	}
+
+	updateMargins();
+	im->startLayout();
+}
+
+void MainTextEdit::setWrapping(bool wrap)
+{
+	// Qt only drops the lines of every block here, the view lays out what it shows and the rest follows in slices.
+	setLineWrapMode(wrap ? QPlainTextEdit::WidgetWidth : QPlainTextEdit::NoWrap);
+	im->startLayout();
+}
+
+void MainTextEdit::setSyntax(std::shared_ptr<SyntaxDefinition const> syntax)
+{
+	im->highlightShown();
+	im->highlighter.setDefinition(std::move(syntax));
+}
+
+UndoHistory const &MainTextEdit::undoHistory() const
+{
+	return im->history;
+}
+
+void MainTextEdit::setUndoEnabled(bool enabled)
+{
+	im->undoEnabled = enabled;
+	if (!enabled)
+	{
+		im->forget();
+	}
+}
+
+void MainTextEdit::prepareEdit(QTextCursor const &cursor)
+{
+	im->take(cursor);
+}
+
+void MainTextEdit::replaceInBuffer(std::vector<qint64> const &starts, qint64 length, QByteArray const &replacement)
+{
+	if (!im->buffer || starts.empty())
+	{
+		return;
+	}
+
+	// The runs of the whole range from the first match to the last are all the step needs, however many there are.
+	const qint64 first = starts.front();
+	const qint64 last = starts.back() + length;
+	std::vector<TextBuffer::Extent> taken;
+	if (im->undoEnabled)
+	{
+		taken = im->buffer->extents(first, last - first);
+	}
+
+	qint64 shift = 0;
+	for (qint64 start : starts)
+	{
+		im->buffer->remove(start + shift, length);
+		im->buffer->insert(start + shift, replacement);
+		emit bufferEdited(start + shift, length, replacement);
+		shift += replacement.size() - length;
+	}
+
+	if (im->undoEnabled)
+	{
+		im->history.record(first, last - first + shift, std::move(taken), false);
+		im->historyChanged();
+	}
+
+	im->reloadAfter(first, last + shift);
+	document()->setModified(true);
+}
+
+void MainTextEdit::undo()
+{
+	if (isReadOnly() || !im->history.canUndo())
+	{
+		return;
+	}
+
+	im->history.pushRedo(im->replay(im->history.takeUndo()));
+	im->replayed();
+}
+
+void MainTextEdit::redo()
 {
-	// No implementation.
+	if (isReadOnly() || !im->history.canRedo())
+	{
+		return;
+	}
+
+	im->history.pushUndo(im->replay(im->history.takeRedo()));
+	im->replayed();
 }
 
 void MainTextEdit::wheelEvent(QWheelEvent *e)
@@ -35,10 +1261,10 @@ void MainTextEdit::wheelEvent(QWheelEvent *e)
 			modAmount *= -1;
 		}
 
-		threshold += modAmount;
-		if (abs(threshold) >= 120)
+		im->threshold += modAmount;
+		if (abs(im->threshold) >= 120)
 		{
-			if (threshold > 0)
+			if (im->threshold > 0)
 			{
 				emit scrollZoomIn();
 			}
@@ -47,7 +1273,7 @@ void MainTextEdit::wheelEvent(QWheelEvent *e)
 				emit scrollZoomOut();
 			}
 
-			threshold = 0;
+			im->threshold = 0;
 		}
 
 		e->accept();
@@ -57,3 +1283,364 @@ void MainTextEdit::wheelEvent(QWheelEvent *e)
 		QPlainTextEdit::wheelEvent(e);
 	}
 }
+
+void MainTextEdit::keyPressEvent(QKeyEvent *e)
+{
+	// The document keeps no history, so it would ignore these.
+	if (e->matches(QKeySequence::Undo))
+	{
+		undo();
+		return;
+	}
+
+	if (e->matches(QKeySequence::Redo))
+	{
+		redo();
+		return;
+	}
+
+	// The document only holds part of the buffer, so jumping to either end has to move the window there first.
+	if (im->buffer && e->modifiers().testFlag(Qt::ControlModifier))
+	{
+		if (e->key() == Qt::Key_Home)
+		{
+			im->loadWindow(0, true);
+		}
+		else if (e->key() == Qt::Key_End)
+		{
+			im->loadEnd();
+		}
+	}
+
+	if (!mayEdit(e))
+	{
+		QPlainTextEdit::keyPressEvent(e);
+		return;
+	}
+
+	// A character typed or deleted on its own adds to the step of the ones before it, anything else is a step of its
+	// own.
+	const QString text = e->text();
+	im->typing = !e->modifiers().testFlag(Qt::ControlModifier)
+	             && (e->key() == Qt::Key_Backspace || e->key() == Qt::Key_Delete
+	                 || (text.size() == 1 && text.front().isPrint()));
+	im->capture(textCursor());
+	QPlainTextEdit::keyPressEvent(e);
+	im->release();
+	im->typing = false;
+}
+
+void MainTextEdit::inputMethodEvent(QInputMethodEvent *e)
+{
+	im->capture(textCursor());
+	QPlainTextEdit::inputMethodEvent(e);
+	im->release();
+}
+
+void MainTextEdit::insertFromMimeData(QMimeData const *source)
+{
+	im->capture(textCursor());
+	QPlainTextEdit::insertFromMimeData(source);
+	im->release();
+}
+
+void MainTextEdit::dropEvent(QDropEvent *e)
+{
+	// Text moved within the document is taken out where it was and put in where it is dropped, both in one edit.
+	QTextCursor around = textCursor();
+	const int at = cursorForPosition(e->position().toPoint()).position();
+	const int from = std::min(at, around.selectionStart());
+	const int to = std::max(at, around.selectionEnd());
+	around.setPosition(from);
+	around.setPosition(to, QTextCursor::KeepAnchor);
+	im->capture(around);
+	QPlainTextEdit::dropEvent(e);
+	im->release();
+}
+
+void MainTextEdit::contextMenuEvent(QContextMenuEvent *e)
+{
+	// The menu's own undo and redo would go to the document.  It is run here until it closes rather than popped up and
+	// left, so the text its other entries edit stays captured for as long as it is open.
+	std::unique_ptr<QMenu> menu(createStandardContextMenu(e->pos()));
+	for (QAction *action : menu->actions())
+	{
+		const bool undoing = action->objectName() == QLatin1String("edit-undo");
+		if (undoing || action->objectName() == QLatin1String("edit-redo"))
+		{
+			QObject::disconnect(action, SIGNAL(triggered(bool)), nullptr, nullptr);
+			QObject::connect(action, SIGNAL(triggered()), this, undoing ? SLOT(undo()) : SLOT(redo()));
+			action->setEnabled(!isReadOnly() && (undoing ? im->history.canUndo() : im->history.canRedo()));
+		}
+	}
+
+	im->capture(textCursor());
+	menu->exec(e->globalPos());
+	im->release();
+}
+
+void MainTextEdit::resizeEvent(QResizeEvent *e)
+{
+	QPlainTextEdit::resizeEvent(e);
+	im->placeOffsetBar();
+	im->placeGutter();
+	// A new width changes how every block wraps, and whatever the last pass found no longer holds.
+	if (lineWrapMode() != QPlainTextEdit::NoWrap && e->oldSize().width() != e->size().width())
+	{
+		im->startLayout();
+	}
+}
+
+void MainTextEdit::offsetBarMoved(int value)
+{
+	if (!im->buffer || im->updating)
+	{
+		return;
+	}
+
+	if (value >= im->offsetBar->maximum())
+	{
+		im->loadEnd();
+	}
+	else
+	{
+		im->loadWindow(im->segmentStartBefore(std::min(qint64(value) << im->barShift, im->size())), false);
+	}
+}
+
+void MainTextEdit::viewScrolled()
+{
+	if (!im->buffer || im->updating || im->lines.empty())
+	{
+		return;
+	}
+
+	const int first = firstVisibleBlock().blockNumber();
+	const int lines = int(im->lines.size());
+	const bool atBottom = verticalScrollBar()->value() == verticalScrollBar()->maximum();
+	im->syncOffsetBar(atBottom && im->windowEnd == im->size() ? im->size()
+	                                                          : im->lines[std::min(first, lines - 1)].byte);
+
+	const bool nearTop = first < WINDOW_MARGIN && im->windowStart > 0;
+	const bool nearBottom = first + im->visibleLines() > lines - WINDOW_MARGIN && im->windowEnd < im->size();
+	if ((nearTop || nearBottom) && !im->shiftPending)
+	{
+		// Reloading the document from inside its own scroll bar's signal is not safe, so defer it.
+		im->shiftPending = true;
+		QMetaObject::invokeMethod(this, "shiftWindow", Qt::QueuedConnection);
+	}
+}
+
+void MainTextEdit::shiftWindow()
+{
+	im->shiftPending = false;
+	if (im->buffer && !im->lines.empty())
+	{
+		const size_t first = std::min(size_t(firstVisibleBlock().blockNumber()), im->lines.size() - 1);
+		im->loadWindow(im->lines[first].byte, true);
+	}
+}
+
+void MainTextEdit::documentEdited(int position, int charsRemoved, int charsAdded)
+{
+	if (im->updating)
+	{
+		return;
+	}
+
+	if (!im->buffer)
+	{
+		im->recordEdit(position, charsRemoved, charsAdded);
+		return;
+	}
+
+	// The reported range can overshoot, both past the end of the document and by repeating unchanged text, so clamp it
+	// and trim whatever the old and new text have in common.
+	QTextDocument *doc = document();
+	charsRemoved = std::clamp(charsRemoved, 0, std::max(0, int(im->mirror.size()) - position));
+	charsAdded = std::clamp(charsAdded, 0, std::max(0, doc->characterCount() - 1 - position));
+	QTextCursor span(doc);
+	span.setPosition(position);
+	span.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+	QString inserted = textOf(span);
+	QString removed = im->mirror.mid(position, charsRemoved);
+	trimCommon(position, removed, inserted);
+	if (!inserted.isEmpty() || !removed.isEmpty())
+	{
+		im->applyEdit(position, removed, inserted);
+		im->updateBarRange();
+	}
+}
+
+void MainTextEdit::modificationChanged(bool changed)
+{
+	if (im->updating || im->replaying)
+	{
+		return;
+	}
+
+	im->modified = changed;
+	// Saved as it is now, or changed in a way none of the steps records, which the saved text is then out of reach of.
+	if (!changed)
+	{
+		im->history.markClean();
+	}
+	else if (im->history.isClean())
+	{
+		im->history.markUnreachable();
+	}
+}
+
+void MainTextEdit::linesIndexed()
+{
+	if (sender() != im->indexThread)
+	{
+		return;
+	}
+
+	im->stopIndexing();
+	if (im->buffer && im->indexed)
+	{
+		im->fileEndings = im->indexed->lineEndings();
+		im->buffer->setLineIndex(std::move(im->indexed));
+		updateMargins();
+		im->gutter->update();
+		emit linesCounted();
+	}
+
+	im->indexed.reset();
+}
+
+void MainTextEdit::layoutSlice()
+{
+	auto *layout = qobject_cast<QPlainTextDocumentLayout *>(document()->documentLayout());
+	if (!layout)
+	{
+		return;
+	}
+
+	// The scrollbar counts lines, so every block above the view that turns out to wrap differently moves the view.
+	// It is put back on the same line of the same block afterwards.
+	const QTextBlock anchor = firstVisibleBlock();
+	const int anchorLine = verticalScrollBar()->value() - anchor.firstLineNumber();
+	const int firstVisible = anchor.blockNumber();
+	const int lastVisible = firstVisible + im->visibleLines();
+	const qreal charWidth = QFontMetricsF(document()->defaultFont()).averageCharWidth();
+	const qreal lineWidth = std::max<qreal>(1, layout->textWidth() - 2 * document()->documentMargin());
+	QElapsedTimer clock;
+	clock.start();
+	QTextBlock block = document()->findBlockByNumber(im->layoutNext);
+	int number = im->layoutNext;
+	while (im->layoutLeft > 0 && clock.elapsed() < LAYOUT_SLICE)
+	{
+		if (!block.isValid())
+		{
+			block = document()->firstBlock();
+			number = 0;
+		}
+
+		if (im->estimating)
+		{
+			// Blocks the view already laid out know their real count.
+			if (block.isVisible() && block.layout()->lineCount() == 0)
+			{
+				block.setLineCount(im->estimateLines(block, charWidth, lineWidth));
+			}
+		}
+		else
+		{
+			layout->blockBoundingRect(block);
+			// Out of view only the size is needed, the lines themselves would just hold on to memory.
+			if (number < firstVisible || number > lastVisible)
+			{
+				block.clearLayout();
+			}
+		}
+
+		block = block.next();
+		++number;
+		if (--im->layoutLeft == 0 && im->estimating)
+		{
+			im->estimating = false;
+			im->layoutLeft = document()->blockCount();
+			block = anchor;
+			number = firstVisible;
+		}
+	}
+
+	im->layoutNext = block.isValid() ? number : 0;
+	emit layout->documentSizeChanged(layout->documentSize());
+	const int line = anchor.firstLineNumber() + anchorLine;
+	if (anchor.isValid() && verticalScrollBar()->value() != line)
+	{
+		verticalScrollBar()->setValue(line);
+	}
+
+	if (im->layoutLeft > 0)
+	{
+		im->layoutTimer.start();
+	}
+}
+
+void MainTextEdit::viewUpdated(QRect const &rect, int dy)
+{
+	im->highlightShown();
+	if (dy != 0)
+	{
+		im->gutter->scroll(0, dy);
+	}
+	else
+	{
+		im->gutter->update(0, rect.y(), im->gutter->width(), rect.height());
+	}
+
+	if (rect.contains(viewport()->rect()))
+	{
+		updateMargins();
+	}
+}
+
+void MainTextEdit::updateMargins()
+{
+	const QMargins margins(im->gutterWidth(), 0, im->buffer ? im->offsetBar->sizeHint().width() : 0, 0);
+	if (viewportMargins() != margins)
+	{
+		setViewportMargins(margins);
+	}
+
+	im->placeGutter();
+}
+
+// Only the blocks in view are numbered, so the cost of painting does not grow with the document.
+void MainTextEdit::paintGutter(QPaintEvent *event)
+{
+	QPainter painter(im->gutter);
+	painter.fillRect(event->rect(), palette().color(QPalette::Window));
+	const qint64 first = im->firstLine();
+	if (first < 0)
+	{
+		return;
+	}
+
+	painter.setFont(document()->defaultFont());
+	painter.setPen(palette().color(QPalette::PlaceholderText));
+	const int width = im->gutter->width() - GUTTER_PADDING;
+	const int height = QFontMetrics(document()->defaultFont()).height();
+	QTextBlock block = firstVisibleBlock();
+	int number = block.blockNumber();
+	qint64 line = first + im->linesBefore(number);
+	int y = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
+	while (block.isValid() && y <= event->rect().bottom())
+	{
+		// Only the first segment of a long line is numbered.
+		const int bottom = y + qRound(blockBoundingRect(block).height());
+		if (block.isVisible() && bottom >= event->rect().top() && !im->continues(number))
+		{
+			painter.drawText(0, y, width, height, Qt::AlignRight, QString::number(line + 1));
+		}
+
+		block = block.next();
+		line += im->continues(++number) ? 0 : 1;
+		y = bottom;
+	}
+}
@@ -20,21 +20,104 @@
 
 #include <QPlainTextEdit>
 
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "lineendings.hpp"
+
+class TextBuffer;
+class SyntaxDefinition;
+class UndoHistory;
+
 class MainTextEdit : public QPlainTextEdit
 {
 	Q_OBJECT
 
 public:
 	explicit MainTextEdit(QWidget *parent = nullptr);
+	~MainTextEdit();
+
+	bool isWindowed() const;
+	void openBuffer(std::shared_ptr<TextBuffer> buffer, bool keepView = false);
+	void closeBuffer();
+	std::shared_ptr<TextBuffer> buffer() const;
+	// Adds what a followed file gained to the end of the buffer, outside the edit history.  A view at the end stays
+	// there, anywhere else it stays where it is and the text shows up once it is scrolled to.
+	void appendToBuffer(QByteArray const &bytes);
+	void scrollToEnd();
+	// The lines of the file are counted on a thread of their own, which has to stop while the file is let go of.
+	void pauseIndexing();
+	void resumeIndexing();
+	qint64 cursorOffset() const;
+	// Map between positions in the document and offsets in the buffer, which are the same thing without one.
+	qint64 offsetOf(int position) const;
+	QTextCursor selectionAt(qint64 offset, qint64 length);
+	// Zero based line of the cursor and number of lines, both -1 while the lines of a buffer are still being counted.
+	qint64 cursorLine() const;
+	qint64 lineCount() const;
+	// Zero based column of the cursor within its line, counting every segment a long line is split into, or -1 while
+	// that line starts too far before the window to be known.
+	qint64 cursorColumn() const;
+	void goToLine(qint64 line);
+	// Breaks typed into a buffer are stored as this, the breaks of its file are known once its lines are counted.
+	void setLineBreak(QString const &lineBreak);
+	std::optional<LineEndings> lineEndings() const;
+	// Changes the font of the document.  Only the view is laid out again right away, the rest of the document follows
+	// in the background.
+	void setDocumentFont(QFont const &font);
+	// Switches wrapping to the width of the view on or off, the same way.
+	void setWrapping(bool wrap);
+	// Colors the text by the given definition, or not at all for none.  What is in view is colored first.
+	void setSyntax(std::shared_ptr<SyntaxDefinition const> syntax);
+	// Undo is kept here rather than by the document, within a budget of memory.
+	UndoHistory const &undoHistory() const;
+	// Turning undo off, as while a file is loaded or followed, also forgets what there was to undo.
+	void setUndoEnabled(bool enabled);
+	// Keeps the text around the selection of cursor, so an edit made through it rather than typed can be undone.  The
+	// document only reports an edit once it is made, when the text it took out is gone.  Keys, input methods, pastes
+	// and drops are prepared here, any other edit that takes text out has to call this right before it is made, or
+	// the history forgets everything there was to undo.  An edit that only adds text needs nothing.
+	void prepareEdit(QTextCursor const &cursor);
+	// Replaces length bytes at each of the offsets of the buffer, which are in order and do not overlap, as one edit
+	// that undoes in one step.
+	void replaceInBuffer(std::vector<qint64> const &starts, qint64 length, QByteArray const &replacement);
+
+public slots:
+	void undo();
+	void redo();
 
 signals:
 	void scrollZoomIn();
 	void scrollZoomOut();
+	void linesCounted();
+	// An edit of the document as it was made to the buffer, in bytes.
+	void bufferEdited(qint64 offset, qint64 removed, QByteArray const &inserted);
 
 protected:
+	bool eventFilter(QObject *watched, QEvent *event) override;
 	void wheelEvent(QWheelEvent *e) override;
+	void keyPressEvent(QKeyEvent *e) override;
+	void inputMethodEvent(QInputMethodEvent *e) override;
+	void insertFromMimeData(QMimeData const *source) override;
+	void dropEvent(QDropEvent *e) override;
+	void contextMenuEvent(QContextMenuEvent *e) override;
+	void resizeEvent(QResizeEvent *e) override;
+
+private slots:
+	void offsetBarMoved(int value);
+	void viewScrolled();
+	void shiftWindow();
+	void documentEdited(int position, int charsRemoved, int charsAdded);
+	void modificationChanged(bool changed);
+	void linesIndexed();
+	void layoutSlice();
+	void viewUpdated(QRect const &rect, int dy);
+	void updateMargins();
 
 private:
-	int threshold;
-};
+	void paintGutter(QPaintEvent *event);
 
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
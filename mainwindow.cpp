@@ -19,41 +19,135 @@
 #include "mainwindow.hpp"
 #include "./ui_mainwindow.h"
 
-#include <QProcess>
 #include <QMessageBox>
 #include <QPrinter>
+#include <QPdfWriter>
 #include <QPageSetupDialog>
 #include <QPrintDialog>
 #include <QFileDialog>
 #include <QFontDialog>
+#include <QInputDialog>
 #include <QFile>
-#include <QTextStream>
+#include <QFileInfo>
 #include <QDesktopServices>
 #include <QCloseEvent>
 #include <QTextCharFormat>
 #include <QRegularExpression>
 #include <QLabel>
+#include <QProgressBar>
+#include <QShortcut>
+#include <QThread>
+#include <QTimer>
+#include <QTextBlock>
+#include <QStringEncoder>
+#include <QActionGroup>
+#include <QScrollBar>
+#include <QLocale>
 
 #include <tuple>
 #include <array>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include "aboutdialog.hpp"
 #include "findreplacedialog.hpp"
+#include "fileloader.hpp"
+#include "filesaver.hpp"
+#include "textsearcher.hpp"
+#include "matchindex.hpp"
+#include "backgroundsearch.hpp"
+#include "mappedfile.hpp"
+#include "textbuffer.hpp"
+#include "textencoding.hpp"
+#include "lineendings.hpp"
+#include "editjournal.hpp"
+#include "filefollower.hpp"
+#include "printjob.hpp"
+#include "syntaxdefinition.hpp"
+#include "undohistory.hpp"
 
 constexpr size_t DEFAULT_ZOOM = 9;
+// Milliseconds zoom steps are gathered for before the document is laid out at the new size.
+constexpr int ZOOM_DELAY = 50;
+// Files at least this large are mapped and edited through a piece table, rather than decoded into the document whole.
+constexpr qint64 LARGE_FILE_THRESHOLD = 128 << 20;
+// Files with a line at least this long are mapped as well, a line that size is too much to lay out as a single block.
+constexpr qint64 LONG_LINE = 64 << 10;
+// Places of a file looked at for such a line, each twice that long.
+constexpr qint64 LONG_LINE_SAMPLES = 16;
+// Amount of text queued for the save thread at a time.
+constexpr qsizetype SAVE_CHUNK = 1 << 20;
+// Bytes of a mapped file looked at for its line endings until all of it has been counted.
+constexpr qint64 LINE_END_SAMPLE = 64 << 10;
+// Milliseconds a message stays in the status bar.
+constexpr int MESSAGE_TIME = 10000;
+// Marks the extra selections that highlight matches, apart from any others.
+constexpr int MATCH_SELECTION = QTextFormat::UserProperty;
+
+namespace
+{
+// Windows share the process that opened them, and go away as soon as they are closed.
+MainWindow *openWindow()
+{
+	MainWindow *window = new MainWindow;
+	window->setAttribute(Qt::WA_DeleteOnClose);
+	window->show();
+	window->raise();
+	window->activateWindow();
+	return window;
+}
+
+bool hasLongLine(const char *pos, const char *end)
+{
+	while (end - pos >= LONG_LINE)
+	{
+		// The search for \r stops at the next \n, so every byte is only looked at about twice.
+		auto *newline = static_cast<const char *>(std::memchr(pos, '\n', LONG_LINE));
+		const char *limit = newline ? newline : pos + LONG_LINE;
+		auto *carriage = static_cast<const char *>(std::memchr(pos, '\r', limit - pos));
+		if (!newline && !carriage)
+		{
+			return true;
+		}
+
+		pos = (carriage ? carriage : newline) + 1;
+	}
+
+	return false;
+}
+
+// Only samples spread over the file are looked at, since this runs on the GUI thread before anything loads.  That is
+// enough to tell a minified file, and a file with one long line somewhere else still loads, only slower.
+bool hasLongLine(QString const &filename)
+{
+	MappedFile mapped(filename);
+	const qint64 size = mapped.isOpen() ? mapped.size() : 0;
+	const qint64 span = 2 * LONG_LINE;
+	const qint64 samples = std::clamp<qint64>(size / span, 1, LONG_LINE_SAMPLES);
+	for (qint64 sample = 0; sample < samples; ++sample)
+	{
+		const qint64 start = samples > 1 ? (size - span) * sample / (samples - 1) : 0;
+		if (hasLongLine(mapped.data() + start, mapped.data() + std::min(size, start + span)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+}
 
 struct MainWindow::Impl
 {
 	Impl(MainWindow *top) :
 	    top(top),
-	    fDialog(top),
-	    pDialog(&filePrinter, top),
-	    psDialog(&filePrinter, top),
-	    about(top),
-	    findrep(top)
+	    cancelShortcut(QKeySequence(Qt::Key_Escape), top)
 	{
 		ui.setupUi(top);
-		fDialog.setCurrentFont(ui.mainEdit->currentCharFormat().font());
 		document = ui.mainEdit->document();
 		ui.mainEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
 		updateFileDisplay();
@@ -64,20 +158,131 @@ struct MainWindow::Impl
 		updateLineColLabel();
 		generateSlideRule();
 		updateZoomLabel();
-		lineEndLabel.setText("UNIX (LF)");
-		formatLabel.setText("UTF-8");
+		QActionGroup *endings = new QActionGroup(top);
+		endings->addAction(ui.actionUnix_LF);
+		endings->addAction(ui.actionWindows_CRLF);
+		endings->addAction(ui.actionMacintosh_CR);
+		setLineEndings(LineEndings());
+		setEncoding(TextEncoding());
+		loadBar.setRange(0, 1000);
+		loadBar.setMaximumWidth(160);
+		//: Shown in the status bar while a file loads, %p is replaced by the percentage loaded.
+		loadBar.setFormat(tr("Loading %p%"));
+		loadBar.setToolTip(tr("Press Esc to cancel loading."));
+		loadBar.hide();
+		printBar.setRange(0, 1000);
+		printBar.setMaximumWidth(160);
+		//: Shown in the status bar while printing, %p is replaced by the percentage of the text laid out.
+		printBar.setFormat(tr("Printing %p%"));
+		printBar.setToolTip(tr("Press Esc to cancel printing."));
+		printBar.hide();
+		cancelShortcut.setEnabled(false);
+		QObject::connect(&cancelShortcut, SIGNAL(activated()), top, SLOT(cancelTask()));
+		savePump.setInterval(0);
+		zoomTimer.setSingleShot(true);
+		zoomTimer.setInterval(ZOOM_DELAY);
+		QObject::connect(&zoomTimer, SIGNAL(timeout()), top, SLOT(applyZoom()));
+		QObject::connect(&savePump, SIGNAL(timeout()), top, SLOT(pumpSave()));
 		ui.statusbar->addPermanentWidget(new QLabel(""));
+		ui.statusbar->addPermanentWidget(&loadBar);
+		ui.statusbar->addPermanentWidget(&printBar);
 		ui.statusbar->addPermanentWidget(&lineColLabel);
 		ui.statusbar->addPermanentWidget(&zoomLabel);
 		ui.statusbar->addPermanentWidget(&lineEndLabel);
 		ui.statusbar->addPermanentWidget(&formatLabel);
-		QObject::connect(&findrep, SIGNAL(findRequested(FindFlags,QString)),
-		                 top,      SLOT(doFindRequest(FindFlags,QString)));
-		QObject::connect(&findrep, SIGNAL(replaceRequested(FindFlags,QString,QString)),
-		                 top,      SLOT(doReplaceRequest(FindFlags,QString,QString)));
-		QObject::connect(&findrep, SIGNAL(replaceAllRequested(FindFlags,QString,QString)),
-		                 top,      SLOT(doReplaceAllRequest(FindFlags,QString,QString)));
-		QObject::connect(top, SIGNAL(nothingToFind()), &findrep, SLOT(reportNoFind()));
+		QObject::connect(&search, SIGNAL(found(qint64,qint64)), top, SLOT(incrementalFound(qint64,qint64)));
+		QObject::connect(&search, SIGNAL(notFound()), top, SIGNAL(nothingToFind()));
+		matches = new MatchIndex(document, top);
+		QObject::connect(matches, SIGNAL(changed()), top, SLOT(matchesChanged()));
+		QObject::connect(ui.mainEdit, SIGNAL(updateRequest(QRect,int)), top, SLOT(viewUpdated()));
+		QObject::connect(document, SIGNAL(contentsChange(int,int,int)), top, SLOT(documentEdited(int,int,int)));
+		QObject::connect(ui.mainEdit, SIGNAL(bufferEdited(qint64,qint64,QByteArray)),
+		                 top,         SLOT(bufferEdited(qint64,qint64,QByteArray)));
+		startJournal();
+	}
+
+	// The dialogs are built the first time they are needed, most sessions never print and the print system is slow to
+	// start up.
+	QPrinter &printer()
+	{
+		if (!filePrinter)
+		{
+			filePrinter = std::make_unique<QPrinter>();
+		}
+
+		return *filePrinter;
+	}
+
+	QFontDialog &fontDialog()
+	{
+		if (!fDialog)
+		{
+			fDialog = std::make_unique<QFontDialog>(top);
+			fDialog->setCurrentFont(ui.mainEdit->currentCharFormat().font());
+		}
+
+		return *fDialog;
+	}
+
+	QPrintDialog &printDialog()
+	{
+		if (!pDialog)
+		{
+			pDialog = std::make_unique<QPrintDialog>(&printer(), top);
+		}
+
+		return *pDialog;
+	}
+
+	QPageSetupDialog &pageSetupDialog()
+	{
+		if (!psDialog)
+		{
+			psDialog = std::make_unique<QPageSetupDialog>(&printer(), top);
+		}
+
+		return *psDialog;
+	}
+
+	AboutDialog &aboutDialog()
+	{
+		if (!about)
+		{
+			about = std::make_unique<AboutDialog>(top);
+		}
+
+		return *about;
+	}
+
+	FindReplaceDialog &findReplace()
+	{
+		if (!findrep)
+		{
+			findrep = std::make_unique<FindReplaceDialog>(top);
+			FindReplaceDialog *dialog = findrep.get();
+			QObject::connect(dialog, SIGNAL(findRequested(FindFlags,QString)),
+			                 top,    SLOT(doFindRequest(FindFlags,QString)));
+			QObject::connect(dialog, SIGNAL(replaceRequested(FindFlags,QString,QString)),
+			                 top,    SLOT(doReplaceRequest(FindFlags,QString,QString)));
+			QObject::connect(dialog, SIGNAL(replaceAllRequested(FindFlags,QString,QString)),
+			                 top,    SLOT(doReplaceAllRequest(FindFlags,QString,QString)));
+			QObject::connect(top, SIGNAL(nothingToFind()), dialog, SLOT(reportNoFind()));
+			QObject::connect(top, SIGNAL(matchCountChanged(int,int)), dialog, SLOT(reportMatchCount(int,int)));
+			QObject::connect(dialog, SIGNAL(finished(int)), top, SLOT(clearMatches()));
+			QObject::connect(dialog, SIGNAL(incrementalSearchRequested(FindFlags,QString)),
+			                 top,    SLOT(doIncrementalSearch(FindFlags,QString)));
+			QObject::connect(dialog, SIGNAL(incrementalSearchCancelled()), top, SLOT(cancelIncrementalSearch()));
+			QObject::connect(dialog, SIGNAL(finished(int)), top, SLOT(cancelIncrementalSearch()));
+		}
+
+		return *findrep;
+	}
+
+	~Impl()
+	{
+		stopLoad();
+		stopPrint();
+		waitForSave();
 	}
 
 	void updateFileDisplay()
@@ -85,13 +290,102 @@ struct MainWindow::Impl
 		QString name = document->isModified() ? "*" : "";
 		name.append(fileName.isEmpty() ? tr("Untitled") : fileName.section('/', -1));
 		top->setWindowTitle(name + tr(" - Simple Qt Text Editor"));
+		// The title follows the file name wherever it changes, so the coloring goes along with it.
+		ui.mainEdit->setSyntax(SyntaxDefinition::forFile(fileName));
+	}
+
+	void setEncoding(TextEncoding const &detected)
+	{
+		encoding = detected;
+		switch (encoding.encoding())
+		{
+		case QStringConverter::Utf16LE:
+			formatLabel.setText(tr("UTF-16 LE"));
+			break;
+		case QStringConverter::Utf16BE:
+			formatLabel.setText(tr("UTF-16 BE"));
+			break;
+		case QStringConverter::Latin1:
+			formatLabel.setText(tr("Latin-1"));
+			break;
+		default:
+			formatLabel.setText(encoding.hasBom() ? tr("UTF-8 with BOM") : tr("UTF-8"));
+			break;
+		}
+	}
+
+	void setLineEndings(LineEndings const &counted)
+	{
+		lineEndings = counted;
+		lineEnding = counted.style();
+		lineEndingConverted = false;
+		ui.mainEdit->setLineBreak(LineEndings::breakText(lineEnding));
+		updateLineEndLabel();
+	}
+
+	QString lineEndingName(LineEndings::Style style) const
+	{
+		switch (style)
+		{
+		case LineEndings::CrLf:
+			return tr("Windows (CRLF)");
+		case LineEndings::Cr:
+			return tr("Macintosh (CR)");
+		default:
+			return tr("UNIX (LF)");
+		}
+	}
+
+	void updateLineEndLabel()
+	{
+		if (lineEndings.isMixed())
+		{
+			lineEndLabel.setText(tr("Mixed (LF %1, CRLF %2, CR %3)")
+			                         .arg(lineEndings.lf())
+			                         .arg(lineEndings.crLf())
+			                         .arg(lineEndings.cr()));
+			lineEndLabel.setToolTip(tr("Saved as %1").arg(lineEndingName(lineEnding)));
+		}
+		else
+		{
+			lineEndLabel.setText(lineEndingName(lineEnding));
+			lineEndLabel.setToolTip(QString());
+		}
+
+		ui.actionUnix_LF->setChecked(lineEnding == LineEndings::Lf);
+		ui.actionWindows_CRLF->setChecked(lineEnding == LineEndings::CrLf);
+		ui.actionMacintosh_CR->setChecked(lineEnding == LineEndings::Cr);
+	}
+
+	// The document has no line breaks of its own to rewrite, only a mapped file does and that happens as it is saved,
+	// so converting just settles how breaks are written from now on.
+	void convertLineEndings(LineEndings::Style style)
+	{
+		if (loader || saver || ui.mainEdit->isReadOnly())
+		{
+			updateLineEndLabel();
+			return;
+		}
+
+		lineEndings = lineEndings.convertedTo(style);
+		lineEnding = style;
+		lineEndingConverted = true;
+		ui.mainEdit->setLineBreak(LineEndings::breakText(style));
+		document->setModified(true);
+		modCheck = true;
+		updateFileDisplay();
+		updateLineEndLabel();
 	}
 
 	void updateLineColLabel()
 	{
-		QTextCursor current = ui.mainEdit->textCursor();
-		QString lineSide = tr("Ln ") + QString::number(current.blockNumber());
-		QString colSide = tr(", Col ") + QString::number(current.positionInBlock());
+		// Line numbers of a mapped file are unknown until all of it has been read, so show where the cursor is instead.
+		// The column of a line split into segments needs the start of the line, which is only known by then as well.
+		const qint64 line = ui.mainEdit->cursorLine();
+		const qint64 column = ui.mainEdit->cursorColumn();
+		QString lineSide = line < 0 ? tr("Offset ") + QString::number(ui.mainEdit->cursorOffset())
+		                            : tr("Ln ") + QString::number(line + 1);
+		QString colSide = column < 0 ? QString() : tr(", Col ") + QString::number(column + 1);
 		lineColLabel.setText(lineSide + colSide);
 	}
 
@@ -103,10 +397,16 @@ struct MainWindow::Impl
 			currentZoom = newZoom;
 		}
 
+		// A turn of the wheel sends a burst of steps, the font is only changed once they stop.
+		updateZoomLabel();
+		zoomTimer.start();
+	}
+
+	void applyZoom()
+	{
 		QFont newSize = document->defaultFont();
 		newSize.setPointSizeF(zoomSlideRule[currentZoom]);
-		document->setDefaultFont(newSize);
-		updateZoomLabel();
+		ui.mainEdit->setDocumentFont(newSize);
 	}
 
 	void generateSlideRule()
@@ -128,6 +428,11 @@ struct MainWindow::Impl
 
 	bool editedCheck()
 	{
+		if (!waitForSave())
+		{
+			return false;
+		}
+
 		if (document->isModified())
 		{
 			auto response = QMessageBox::question(top, tr("Current File Has Been Modified"),
@@ -136,7 +441,9 @@ struct MainWindow::Impl
 			                                      QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
 			if (response == QMessageBox::Yes)
 			{
+				// The document may only be discarded once it is really on disk, which also rules out a cancelled Save As.
 				top->saveFile();
+				return waitForSave() && !document->isModified();
 			}
 
 			return response != QMessageBox::Cancel;
@@ -147,12 +454,13 @@ struct MainWindow::Impl
 
 	void openFindReplace(bool findOrReplace)
 	{
-		findrep.focusFind(findOrReplace);
+		FindReplaceDialog &dialog = findReplace();
+		dialog.focusFind(findOrReplace);
 		if (QTextCursor content = ui.mainEdit->textCursor(); content.hasSelection())
 		{
-			findrep.setFindText(content.selectedText());
+			dialog.setFindText(content.selectedText());
 		}
-		findrep.show();
+		dialog.show();
 	}
 
 	std::tuple<QTextDocument::FindFlags, bool, bool> breakdownFindFlags(FindFlags flags)
@@ -169,8 +477,21 @@ struct MainWindow::Impl
 	QTextCursor findNext(FindFlags flags, QString const &seek, QTextCursor const &startPos)
 	{
 		auto [findflag, isRegex, shouldWrap] = breakdownFindFlags(flags);
+		if (!ui.mainEdit->isWindowed() && matches->covers(flags, seek) && matches->isComplete())
+		{
+			return findIndexed(flags, startPos);
+		}
+
+		if (!isRegex)
+		{
+			return findLiteral(flags, seek, startPos);
+		}
+
+		// The expression already carries the case option, so QTextDocument does not have to detach and recompile it.
+		const Qt::CaseSensitivity cs = findflag.testFlag(QTextDocument::FindCaseSensitively) ? Qt::CaseSensitive
+		                                                                                     : Qt::CaseInsensitive;
 		auto findStr = [&](auto f, auto fPos, bool regx) {
-			return regx ? document->find(QRegularExpression(seek), fPos, f)
+			return regx ? document->find(TextSearcher::cachedRegex(seek, cs), fPos, f)
 			            : document->find(seek, fPos, f);
 		};
 
@@ -184,8 +505,755 @@ struct MainWindow::Impl
 		return select;
 	}
 
+	// Stepping through the index is a binary search, however many matches there are.
+	QTextCursor findIndexed(FindFlags flags, QTextCursor const &startPos)
+	{
+		const bool backward = flags.test(0);
+		int index = backward ? matches->lowerBound(startPos.selectionStart()) - 1
+		                     : matches->lowerBound(startPos.selectionEnd());
+		if (index < 0 || index >= matches->count())
+		{
+			if (!flags.test(4) || matches->count() == 0)
+			{
+				return QTextCursor();
+			}
+
+			index = backward ? matches->count() - 1 : 0;
+		}
+
+		const MatchIndex::Match match = matches->at(index);
+		QTextCursor select(document);
+		select.setPosition(match.start);
+		select.setPosition(match.start + match.length, QTextCursor::KeepAnchor);
+		return select;
+	}
+
+	// Literal searches scan the whole text at once instead of going block by block, and in windowed mode they cover the
+	// whole buffer rather than just the window.
+	QTextCursor findLiteral(FindFlags flags, QString const &seek, QTextCursor const &startPos)
+	{
+		const TextSearcher searcher(flags, seek);
+		const bool backward = flags.test(0);
+		const int startChar = backward ? startPos.selectionStart() : startPos.selectionEnd();
+		if (ui.mainEdit->isWindowed())
+		{
+			TextBuffer const &buffer = *ui.mainEdit->buffer();
+			qint64 found = searcher.find(buffer, ui.mainEdit->offsetOf(startChar), backward);
+			if (found < 0 && flags.test(4))
+			{
+				found = searcher.find(buffer, backward ? buffer.size() : 0, backward);
+			}
+
+			return found < 0 ? QTextCursor() : ui.mainEdit->selectionAt(found, searcher.byteLength());
+		}
+
+		QString const &text = documentText();
+		qint64 found = searcher.find(text, startChar, backward);
+		if (found < 0 && flags.test(4))
+		{
+			found = searcher.find(text, backward ? text.size() : 0, backward);
+		}
+
+		if (found < 0)
+		{
+			return QTextCursor();
+		}
+
+		QTextCursor select(document);
+		select.setPosition(int(found));
+		select.setPosition(int(found + seek.size()), QTextCursor::KeepAnchor);
+		return select;
+	}
+
+	// The document as a single string, where every position is the same as in the document.
+	QString const &documentText()
+	{
+		if (!searchTextValid)
+		{
+			searchText = document->toRawText();
+			searchTextValid = true;
+		}
+
+		return searchText;
+	}
+
+	bool openBuffer(QString const &filename, bool keepView = false)
+	{
+		auto mapped = std::make_shared<MappedFile>(filename);
+		if (!mapped->isOpen())
+		{
+			return false;
+		}
+
+		// The window decodes and encodes the buffer as UTF-8, any other encoding has to be loaded in full.
+		const TextEncoding detected = TextEncoding::detect(mapped->data(), mapped->size(), true);
+		if (!detected.isUtf8())
+		{
+			return false;
+		}
+
+		setEncoding(detected);
+		showBuffer(std::move(mapped), keepView);
+		return true;
+	}
+
+	void showBuffer(std::shared_ptr<MappedFile> mapped, bool keepView)
+	{
+		LineEndings sample;
+		sample.count(mapped->data(), mapped->data() + std::min(mapped->size(), LINE_END_SAMPLE));
+		setLineEndings(sample);
+		ui.mainEdit->openBuffer(std::make_shared<TextBuffer>(std::move(mapped)), keepView);
+	}
+
+	// Makes the edits to the buffer and journals them, the window is only loaded again once they are all in.
+	void replayEdits(std::vector<EditJournal::Edit> const &edits)
+	{
+		std::shared_ptr<TextBuffer> buffer = ui.mainEdit->buffer();
+		for (EditJournal::Edit const &edit : edits)
+		{
+			const qint64 position = std::clamp<qint64>(edit.position, 0, buffer->size());
+			const qint64 removed = std::clamp<qint64>(edit.removed, 0, buffer->size() - position);
+			buffer->remove(position, removed);
+			buffer->insert(position, edit.inserted);
+			journal->record(position, removed, edit.inserted);
+		}
+
+		ui.mainEdit->openBuffer(buffer, true);
+		document->setModified(true);
+	}
+
+	// Edits are journaled from the state the file was opened or saved in, which is what they replay against.
+	void startJournal()
+	{
+		journal = std::make_unique<EditJournal>(fileName, ui.mainEdit->isWindowed() ? EditJournal::Bytes
+		                                                                              : EditJournal::Chars);
+		journalChars = document->characterCount();
+	}
+
+	// A window nobody has used yet, which a recovered document can take over.
+	bool isPristine() const
+	{
+		return !loader && fileName.isEmpty() && !document->isModified() && !ui.mainEdit->isWindowed() && !recovered;
+	}
+
+	void recover(EditJournal::Orphan orphan)
+	{
+		recovered = std::move(orphan);
+		if (recovered->fileName.isEmpty())
+		{
+			applyRecovered();
+		}
+		else
+		{
+			top->loadFile(recovered->fileName);
+		}
+	}
+
+	// Replays the edits of a crashed session once their file is open again.  They go through the new journal like
+	// any other edit, and only then is the old one removed.
+	void applyRecovered()
+	{
+		if (!recovered || recovered->fileName != fileName)
+		{
+			recovered.reset();
+			return;
+		}
+
+		if (recovered->units != journal->units())
+		{
+			QMessageBox::warning(top, tr("Unsaved Edits Lost"),
+			                     tr("The file is no longer opened the way it was when it was edited, so the edits "
+			                        "could not be recovered."));
+		}
+		else if (ui.mainEdit->isWindowed())
+		{
+			replayEdits(recovered->edits);
+		}
+		else
+		{
+			// All of it undoes in one step.
+			QTextCursor cursor(document);
+			cursor.select(QTextCursor::Document);
+			ui.mainEdit->prepareEdit(cursor);
+			cursor.beginEditBlock();
+			for (EditJournal::Edit const &edit : recovered->edits)
+			{
+				const int last = document->characterCount() - 1;
+				cursor.setPosition(int(std::clamp<qint64>(edit.position, 0, last)));
+				cursor.setPosition(int(std::clamp<qint64>(edit.position + edit.removed, 0, last)),
+				                   QTextCursor::KeepAnchor);
+				cursor.insertText(QString::fromUtf8(edit.inserted));
+			}
+
+			cursor.endEditBlock();
+			document->setModified(true);
+		}
+
+		EditJournal::remove(*recovered);
+		recovered.reset();
+		modCheck = document->isModified();
+		updateFileDisplay();
+	}
+
+	// While a file is followed the document only ever mirrors it, so it cannot be edited and nothing is journaled.
+	void startFollowing()
+	{
+		journal.reset();
+		ui.mainEdit->setUndoEnabled(false);
+		ui.mainEdit->setReadOnly(true);
+		// A buffer is only ever followed unmodified, so it holds just what the file did.
+		const bool windowed = ui.mainEdit->isWindowed();
+		follower = std::make_unique<FileFollower>(fileName, windowed ? ui.mainEdit->buffer()->size() : loadedBytes,
+		                                          encoding);
+		follower->setRaw(windowed);
+		followMapped = windowed;
+		QObject::connect(follower.get(), SIGNAL(appended(QString)), top, SLOT(followAppended(QString)));
+		QObject::connect(follower.get(), SIGNAL(bytesAppended(QByteArray)), top,
+		                 SLOT(followBytesAppended(QByteArray)));
+		QObject::connect(follower.get(), SIGNAL(restarted()), top, SLOT(followRestarted()));
+	}
+
+	// Maps the file as it is now and follows it on from its end, once it grew too large for the document or when it
+	// was replaced while mapped.  Returns false when it cannot be mapped, which leaves it followed as it was.
+	bool followMapping()
+	{
+		followMapped = true;
+		if (!openBuffer(fileName))
+		{
+			return false;
+		}
+
+		follower->skipTo(ui.mainEdit->buffer()->size());
+		follower->setRaw(true);
+		ui.mainEdit->scrollToEnd();
+		return true;
+	}
+
+	void stopFollowing()
+	{
+		if (!follower)
+		{
+			return;
+		}
+
+		loadedBytes = follower->offset();
+		follower.reset();
+		ui.actionFollow_File->setChecked(false);
+		ui.mainEdit->setUndoEnabled(true);
+		ui.mainEdit->setReadOnly(false);
+		startJournal();
+	}
+
+	void startLoad(QString const &filename)
+	{
+		stopLoad();
+		journal.reset();
+		loadedBytes = 0;
+		ui.mainEdit->closeBuffer();
+		// The document is filled in batches while the user can already scroll it, none of which should be undoable.
+		ui.mainEdit->setUndoEnabled(false);
+		document->setPlainText("");
+		ui.mainEdit->setReadOnly(true);
+		fileName = filename;
+		document->setModified(false);
+		modCheck = false;
+		updateFileDisplay();
+		setLineEndings(LineEndings());
+		setEncoding(TextEncoding());
+		lossyDecode = false;
+
+		loader = new FileLoader(filename);
+		loaderThread = new QThread(top);
+		loader->moveToThread(loaderThread);
+		QObject::connect(loaderThread, SIGNAL(started()), loader, SLOT(run()));
+		QObject::connect(loaderThread, SIGNAL(finished()), loader, SLOT(deleteLater()));
+		QObject::connect(loader, SIGNAL(batchReady(QString)), top, SLOT(loadBatch(QString)));
+		QObject::connect(loader, SIGNAL(progress(qint64,qint64)), top, SLOT(loadProgress(qint64,qint64)));
+		QObject::connect(loader, SIGNAL(finished()), top, SLOT(loadFinished()));
+		QObject::connect(loader, SIGNAL(failed()), top, SLOT(loadFailed()));
+		loadBar.setValue(0);
+		loadBar.show();
+		cancelShortcut.setEnabled(true);
+		loaderThread->start();
+	}
+
+	void stopLoad()
+	{
+		if (loaderThread)
+		{
+			loader->cancel();
+			loaderThread->quit();
+			loaderThread->wait();
+			delete loaderThread;
+			loaderThread = nullptr;
+			loader = nullptr;
+		}
+
+		loadBar.hide();
+		cancelShortcut.setEnabled(printJob != nullptr);
+		ui.mainEdit->setUndoEnabled(true);
+		ui.mainEdit->setReadOnly(false);
+	}
+
+	// The job works from a snapshot, the document itself stays editable while it prints.  The device is only given
+	// back once the job is finished, so printing again waits until then.
+	void startPrint(QPagedPaintDevice *device, int firstPage = 0, int lastPage = 0)
+	{
+		printJob = new PrintJob(device, document->defaultFont());
+		if (ui.mainEdit->isWindowed())
+		{
+			printJob->setBuffer(*ui.mainEdit->buffer());
+		}
+		else
+		{
+			printJob->setText(documentText());
+		}
+
+		printJob->setPageRange(firstPage, lastPage);
+		printThread = new QThread(top);
+		printJob->moveToThread(printThread);
+		QObject::connect(printThread, SIGNAL(started()), printJob, SLOT(run()));
+		QObject::connect(printThread, SIGNAL(finished()), printJob, SLOT(deleteLater()));
+		QObject::connect(printJob, SIGNAL(progress(qint64,qint64)), top, SLOT(printProgress(qint64,qint64)));
+		QObject::connect(printJob, SIGNAL(finished()), top, SLOT(printFinished()));
+		ui.actionPage_Set_up->setEnabled(false);
+		ui.action_Print->setEnabled(false);
+		ui.actionExport_PDF->setEnabled(false);
+		printBar.setValue(0);
+		printBar.show();
+		cancelShortcut.setEnabled(true);
+		printThread->start();
+	}
+
+	// Tells how the job went once it is done.
+	void endPrint()
+	{
+		const bool cancelled = printJob->wasCancelled();
+		const int pages = printJob->pageCount();
+		if (finishPrint())
+		{
+			ui.statusbar->showMessage(tr("Printed %n page(s).", "", pages), 5000);
+		}
+		else if (cancelled)
+		{
+			ui.statusbar->showMessage(tr("Printing cancelled."), 5000);
+		}
+		else
+		{
+			QMessageBox::critical(top, tr("Printing Failed"), tr("The document could not be printed."));
+		}
+	}
+
+	// Returns whether the job painted every page, false if it failed or was cancelled.
+	bool finishPrint()
+	{
+		const bool ok = printJob->succeeded();
+		printThread->quit();
+		printThread->wait();
+		delete printThread;
+		printThread = nullptr;
+		printJob = nullptr;
+		printBar.hide();
+		cancelShortcut.setEnabled(loader != nullptr);
+		ui.actionPage_Set_up->setEnabled(true);
+		ui.action_Print->setEnabled(true);
+		ui.actionExport_PDF->setEnabled(true);
+		if (pdfWriter)
+		{
+			// A PDF cut short is no use to anyone.
+			pdfWriter.reset();
+			if (!ok)
+			{
+				QFile::remove(pdfName);
+			}
+		}
+
+		return ok;
+	}
+
+	void stopPrint()
+	{
+		if (printJob)
+		{
+			printJob->cancel();
+			finishPrint();
+		}
+	}
+
+	void startSave(QString const &filename)
+	{
+		stopFollowing();
+		waitForSave();
+		saveName = filename;
+		saver = new FileSaver(filename);
+		if (ui.mainEdit->isWindowed())
+		{
+			// A copy of the piece table is all the worker needs, so editing can carry on while it writes.
+			std::shared_ptr<TextBuffer> buffer = ui.mainEdit->buffer();
+			saver->setBuffer(*buffer);
+			savingOver = QFileInfo(filename) == QFileInfo(buffer->original()->fileName());
+			editsDuringSave.clear();
+			if (lineEndingConverted)
+			{
+				saver->setLineBreak(LineEndings::breakBytes(lineEnding));
+				// Edits made meanwhile could not be replayed onto a file whose breaks changed length.
+				ui.mainEdit->setReadOnly(savingOver);
+			}
+
+			savedRevision = buffer->revision();
+		}
+		else
+		{
+			// Blocks are read on this thread, so the document has to hold still until the last one is queued.
+			ui.mainEdit->setReadOnly(true);
+			saveEncoder = encoding.encoder();
+			saveBlock = document->begin();
+			savePump.start();
+		}
+
+		saverThread = new QThread(top);
+		saver->moveToThread(saverThread);
+		QObject::connect(saverThread, SIGNAL(started()), saver, SLOT(run()));
+		QObject::connect(saver, SIGNAL(finished()), top, SLOT(saveFinished()));
+		saverThread->start();
+		ui.statusbar->showMessage(tr("Saving..."));
+	}
+
+	// Queues the text of the next run of blocks, returns true once the whole document has been handed over.
+	bool pumpSave(bool wait)
+	{
+		forever
+		{
+			if (pendingChunk.isEmpty())
+			{
+				if (!saveBlock.isValid())
+				{
+					saver->close();
+					savePump.stop();
+					return true;
+				}
+
+				while (saveBlock.isValid() && pendingChunk.size() < SAVE_CHUNK)
+				{
+					QString line = saveBlock.text();
+					// Only Latin-1 can fail this, for any other encoding it is a single comparison.  Characters were
+					// typed that it cannot hold, and saving would turn them into question marks.
+					if (!encoding.canEncode(line))
+					{
+						saveUnencodable = true;
+						saver->cancel();
+						savePump.stop();
+						return true;
+					}
+
+					saveBlock = saveBlock.next();
+					if (saveBlock.isValid())
+					{
+						line += LineEndings::breakText(lineEnding);
+					}
+
+					pendingChunk += QByteArray(saveEncoder.encode(line));
+				}
+			}
+
+			if (!saver->push(pendingChunk, wait))
+			{
+				return false;
+			}
+
+			pendingChunk.clear();
+			if (!wait)
+			{
+				// One chunk per timer tick keeps the event loop turning over while a big document is saved.
+				return false;
+			}
+		}
+	}
+
+	// Finishing a save can start it over in another encoding, which is waited for as well.
+	bool waitForSave()
+	{
+		while (saver)
+		{
+			if (savePump.isActive())
+			{
+				pumpSave(true);
+			}
+
+			if (!finishSave())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Asks before a file moves over to UTF-8, since whatever else reads it may expect the encoding it had.
+	bool saveAsUtf8()
+	{
+		if (QMessageBox::question(top, tr("Change Encoding"),
+		                          tr("The document holds characters that Latin-1 cannot represent. "
+		                             "Do you want to save it as UTF-8 instead?"))
+		    != QMessageBox::Yes)
+		{
+			ui.statusbar->showMessage(tr("The file was not saved."), 5000);
+			return false;
+		}
+
+		setEncoding(TextEncoding(QStringConverter::Utf8));
+		startSave(saveName);
+		return true;
+	}
+
+	bool finishSave()
+	{
+		saverThread->quit();
+		saverThread->wait();
+		delete saverThread;
+		saverThread = nullptr;
+		savePump.stop();
+		pendingChunk.clear();
+		ui.statusbar->clearMessage();
+		saveHeld = false;
+		if (!ui.mainEdit->isWindowed() || savingOver)
+		{
+			ui.mainEdit->setReadOnly(false);
+		}
+
+		std::shared_ptr<MappedFile> released;
+		if (savingOver && saver->succeeded())
+		{
+			released = releaseMapping();
+		}
+
+		const bool ok = saver->commit();
+		delete saver;
+		saver = nullptr;
+		const bool replaced = std::exchange(savingOver, false);
+		const std::vector<EditJournal::Edit> edits = std::move(editsDuringSave);
+		editsDuringSave.clear();
+		if (!ok && std::exchange(saveUnencodable, false))
+		{
+			return saveAsUtf8();
+		}
+
+		if (!ok)
+		{
+			// The file was left as it was, so it can be mapped again just the same.
+			if (released && !released->reopen())
+			{
+				lostMapping();
+			}
+			else if (released)
+			{
+				ui.mainEdit->resumeIndexing();
+			}
+
+			QMessageBox::critical(top, tr("File Failed to Save"),
+			                      tr("Saving the selected filename failed, the reason was not diagnosed."));
+			return false;
+		}
+
+		fileName = saveName;
+		lossyDecode = false;
+		if (!ui.mainEdit->isWindowed())
+		{
+			document->setModified(false);
+			loadedBytes = QFileInfo(fileName).size();
+			startJournal();
+		}
+		else if (replaced)
+		{
+			// The old mapping is gone along with every piece of the edit history that referenced it.  The file written
+			// is what the buffer held when the save started, so edits made since then are made again on top of it.
+			auto written = std::make_shared<MappedFile>(fileName);
+			if (!written->isOpen())
+			{
+				lostMapping();
+				return true;
+			}
+
+			showBuffer(std::move(written), true);
+			document->setModified(false);
+			startJournal();
+			if (!edits.empty())
+			{
+				replayEdits(edits);
+			}
+		}
+		else if (ui.mainEdit->buffer()->revision() == savedRevision)
+		{
+			// Remapping what was just written drops the old mapping and every piece of the edit history with it.  When
+			// edits were made during the save the written file does not have them, so the buffer is kept as it is.
+			openBuffer(fileName, true);
+			document->setModified(false);
+			startJournal();
+		}
+		else
+		{
+			// Those edits are relative to a file that no longer exists, so journaling waits for the next save.
+			journal.reset();
+		}
+
+		modCheck = document->isModified();
+		updateFileDisplay();
+		return true;
+	}
+
+	// Windows refuses to replace a file that is still mapped, so the mapping is let go of before the save is
+	// committed, once nothing reads the file in the background anymore.  A search is simply dropped.
+	std::shared_ptr<MappedFile> releaseMapping()
+	{
+		if (printJob)
+		{
+			endPrint();
+		}
+
+		search.cancel();
+		search.wait();
+		ui.mainEdit->pauseIndexing();
+		std::shared_ptr<MappedFile> mapped = ui.mainEdit->buffer()->original();
+		mapped->release();
+		return mapped;
+	}
+
+	// Once the mapping is gone for good nothing of the file can be shown anymore, so the window is emptied.
+	void lostMapping()
+	{
+		ui.mainEdit->closeBuffer();
+		document->setPlainText("");
+		fileName.clear();
+		setEncoding(TextEncoding());
+		setLineEndings(LineEndings());
+		startJournal();
+		modCheck = false;
+		updateFileDisplay();
+		QMessageBox::critical(top, tr("File Failed to Open"),
+		                      tr("The file could not be opened again after saving it, so it was closed."));
+	}
+
+	bool replaceAll(FindFlags flags, QString const &seek, QString const &replace)
+	{
+		TextSearcher searcher(flags, seek);
+		if (!searcher.isValid())
+		{
+			return false;
+		}
+
+		searcher.setReplacement(replace);
+		if (ui.mainEdit->isWindowed())
+		{
+			return replaceAllInBuffer(searcher, replace);
+		}
+
+		// Every block from the first to the last one holding a match is rebuilt into one string, which then replaces
+		// that range in a single edit.  The document is relaid out once and the whole run undoes in one step.
+		QString output;
+		qsizetype kept = 0;
+		int first = -1, last = -1;
+		for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+		{
+			if (first >= 0)
+			{
+				output.append('\n');
+			}
+
+			const qsizetype blockStart = output.size();
+			const QString text = block.text();
+			if (searcher.replaceInto(text, output) > 0)
+			{
+				if (first < 0)
+				{
+					first = block.position();
+				}
+
+				last = block.position() + block.length() - 1;
+				kept = output.size();
+			}
+			else if (first < 0)
+			{
+				output.truncate(blockStart);
+			}
+		}
+
+		if (first < 0)
+		{
+			return false;
+		}
+
+		output.truncate(kept);
+		QTextCursor range(document);
+		range.setPosition(first);
+		range.setPosition(last, QTextCursor::KeepAnchor);
+		ui.mainEdit->prepareEdit(range);
+		range.beginEditBlock();
+		range.insertText(output);
+		range.endEditBlock();
+		return true;
+	}
+
+	// The document only holds the window, so the matches are found in the whole buffer the way findLiteral finds
+	// them.  A regular expression is only ever matched against the window, which would replace part of the file.
+	bool replaceAllInBuffer(TextSearcher const &searcher, QString const &replace)
+	{
+		if (!searcher.isLiteral())
+		{
+			QMessageBox::information(top, tr("Replace All"),
+			                         tr("Regular expressions are only matched against the part of a large file "
+			                            "that is in view, so Replace All only works with plain text for this file."));
+			return true;
+		}
+
+		const std::vector<qint64> starts = searcher.findAll(*ui.mainEdit->buffer());
+		if (starts.empty())
+		{
+			return false;
+		}
+
+		ui.mainEdit->replaceInBuffer(starts, searcher.byteLength(), replace.toUtf8());
+		return true;
+	}
+
+	// Only the matches in view are highlighted, which keeps the cost independent of how many there are in total.  The
+	// range is compared against the last one, as setting the selections requests another update of the view.  Extra
+	// selections that are not matches are kept as they are.
+	void highlightMatches(bool force)
+	{
+		QWidget *viewport = ui.mainEdit->viewport();
+		const int from = ui.mainEdit->cursorForPosition(QPoint(0, 0)).block().position();
+		const QTextBlock last = ui.mainEdit->cursorForPosition(QPoint(viewport->width(), viewport->height())).block();
+		const int to = last.position() + last.length();
+		if (!force && from == highlightFrom && to == highlightTo)
+		{
+			return;
+		}
+
+		highlightFrom = from;
+		highlightTo = to;
+		QList<QTextEdit::ExtraSelection> selections = ui.mainEdit->extraSelections();
+		selections.removeIf([](QTextEdit::ExtraSelection const &selection) {
+			return selection.format.hasProperty(MATCH_SELECTION);
+		});
+
+		for (int i = matches->lowerBound(from); i < matches->count() && matches->at(i).start < to; ++i)
+		{
+			const MatchIndex::Match match = matches->at(i);
+			QTextEdit::ExtraSelection selection;
+			selection.cursor = QTextCursor(document);
+			selection.cursor.setPosition(match.start);
+			selection.cursor.setPosition(match.start + match.length, QTextCursor::KeepAnchor);
+			selection.format.setBackground(QColor(255, 230, 0));
+			selection.format.setProperty(MATCH_SELECTION, true);
+			selections.append(selection);
+		}
+
+		ui.mainEdit->setExtraSelections(selections);
+	}
+
 	bool doFindRequest(FindFlags flags, QString const &seek)
 	{
+		matches->setSearch(flags, seek);
 		if (QTextCursor select = findNext(flags, seek); !select.isNull())
 		{
 			ui.mainEdit->setTextCursor(select);
@@ -199,16 +1267,66 @@ struct MainWindow::Impl
 	Ui::MainWindow ui;
 	std::array<qreal, 50> zoomSlideRule;
 	size_t currentZoom = DEFAULT_ZOOM;
+	QTimer zoomTimer;
 	QString fileName;
-	QPrinter filePrinter;
+	std::unique_ptr<QPrinter> filePrinter;
 	QTextDocument *document;
-	QFontDialog fDialog;
-	QPrintDialog pDialog;
-	QPageSetupDialog psDialog;
+	std::unique_ptr<QFontDialog> fDialog;
+	std::unique_ptr<QPrintDialog> pDialog;
+	std::unique_ptr<QPageSetupDialog> psDialog;
 	QLabel lineColLabel, zoomLabel, lineEndLabel, formatLabel;
-	AboutDialog about;
-	FindReplaceDialog findrep;
+	QProgressBar loadBar;
+	QProgressBar printBar;
+	std::unique_ptr<AboutDialog> about;
+	std::unique_ptr<FindReplaceDialog> findrep;
+	QShortcut cancelShortcut;
+	FileLoader *loader = nullptr;
+	QThread *loaderThread = nullptr;
+	FileSaver *saver = nullptr;
+	QThread *saverThread = nullptr;
+	PrintJob *printJob = nullptr;
+	QThread *printThread = nullptr;
+	std::unique_ptr<QPdfWriter> pdfWriter;
+	QString pdfName;
+	QTimer savePump;
+	QTextBlock saveBlock;
+	QByteArray pendingChunk;
+	QStringEncoder saveEncoder;
+	QString saveName;
+	TextEncoding encoding;
+	LineEndings lineEndings;
+	LineEndings::Style lineEnding = LineEndings::Lf;
+	// Whether breaks of a mapped file still have to be rewritten as it is saved.
+	bool lineEndingConverted = false;
+	// Set while a mapped file is saved over itself, with the edits made in the meantime to replay onto what was
+	// written.  The save is held back while a print job still reads the file, and finished along with the job.
+	bool savingOver = false;
+	bool saveHeld = false;
+	std::vector<EditJournal::Edit> editsDuringSave;
+	// Set when the document turned out to hold characters the encoding cannot, which cancels the save.
+	bool saveUnencodable = false;
+	// Whether the file held invalid UTF-8 that was loaded as replacement characters, which saving writes back.
+	bool lossyDecode = false;
+	quint64 savedRevision = 0;
+	QString searchText;
+	bool searchTextValid = false;
+	MatchIndex *matches;
+	BackgroundSearch search;
+	// Whether the running incremental search reports offsets into the buffer rather than positions in the document.
+	bool searchInBuffer = false;
+	int highlightFrom = -1;
+	int highlightTo = -1;
 	bool modCheck = false;
+	std::unique_ptr<EditJournal> journal;
+	// Characters in the document after the last edit, which bounds how many an edit can have removed.
+	int journalChars = 0;
+	// Edits of a crashed session, waiting for their file to be loaded.
+	std::optional<EditJournal::Orphan> recovered;
+	std::unique_ptr<FileFollower> follower;
+	// Whether the followed file was mapped, or at least tried to be, so the attempt is not repeated on every append.
+	bool followMapped = false;
+	// How much of the file the document holds, where following it picks up.
+	qint64 loadedBytes = 0;
 };
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -218,9 +1336,37 @@ MainWindow::MainWindow(QWidget *parent) :
 	// No implementation.
 }
 
-MainWindow::~MainWindow()
+MainWindow::~MainWindow()
+{
+	// No implementation.
+}
+
+void MainWindow::loadFile(QString const &filename)
 {
-	// No implementation.
+	cancelLoad();
+	im->stopFollowing();
+	QFile fileToOpen(filename);
+	// Minified and other single line files are split into segments by the window, however small they are.
+	if ((QFileInfo(filename).size() >= LARGE_FILE_THRESHOLD || hasLongLine(filename)) && im->openBuffer(filename))
+	{
+		// The window writes back the bytes it was given, invalid or not.
+		im->fileName = filename;
+		im->lossyDecode = false;
+		im->modCheck = false;
+		im->updateFileDisplay();
+		im->startJournal();
+		im->applyRecovered();
+	}
+	else if (fileToOpen.open(QIODeviceBase::ReadOnly))
+	{
+		fileToOpen.close();
+		im->startLoad(filename);
+	}
+	else
+	{
+		QMessageBox::critical(this, tr("File Failed to Open"),
+		                      tr("Opening the selected file failed, the reason was not diagnosed."));
+	}
 }
 
 
@@ -228,20 +1374,22 @@ void MainWindow::newFile()
 {
 	if (im->editedCheck())
 	{
+		im->stopFollowing();
+		im->stopLoad();
+		im->journal.reset();
 		im->fileName.clear();
+		im->ui.mainEdit->closeBuffer();
 		im->document->setPlainText("");
+		im->setEncoding(TextEncoding());
+		im->setLineEndings(LineEndings());
 		im->updateFileDisplay();
+		im->startJournal();
 	}
 }
 
 void MainWindow::newWindow()
 {
-	QString appLoc = qApp->applicationFilePath();
-	if (!QProcess::startDetached(appLoc))
-	{
-		QMessageBox::warning(this, tr("New Window Creation Failed"),
-		                     tr("Creating a new Simple Qt Text Editor window failed."));
-	}
+	openWindow();
 }
 
 void MainWindow::openFile()
@@ -250,27 +1398,18 @@ void MainWindow::openFile()
 	{
 		if (im->editedCheck())
 		{
-			QFile fileToOpen(filename);
-			if (fileToOpen.open(QIODeviceBase::ReadOnly))
-			{
-				QTextStream in(&fileToOpen);
-				im->document->setPlainText(in.readAll());
-				im->fileName = filename;
-				im->document->setModified(false);
-				im->modCheck = false;
-				im->updateFileDisplay();
-			}
-			else
-			{
-				QMessageBox::critical(this, tr("File Failed to Open"),
-				                      tr("Opening the selected file failed, the reason was not diagnosed."));
-			}
+			loadFile(filename);
 		}
 	}
 }
 
 void MainWindow::saveAs()
 {
+	if (im->loader)
+	{
+		return;
+	}
+
 	if (QString filename = QFileDialog::getSaveFileName(this, tr("Save As...")); !filename.isNull())
 	{
 		QFile fileLoc(filename);
@@ -285,61 +1424,71 @@ void MainWindow::saveAs()
 			}
 		}
 
-		if (fileLoc.open(QIODeviceBase::WriteOnly | QIODeviceBase::Truncate))
-		{
-			QTextStream out(&fileLoc);
-			out << im->ui.mainEdit->toPlainText();
-			im->document->setModified(false);
-			im->modCheck = false;
-			im->fileName = filename;
-			im->updateFileDisplay();
-		}
-		else
-		{
-			QMessageBox::critical(this, tr("File Failed to Save"),
-			                      tr("Saving the selected filename failed, the reason was not diagnosed."));
-		}
+		im->startSave(filename);
 	}
 }
 
 void MainWindow::saveFile()
 {
+	if (im->loader)
+	{
+		// Saving now would write out a partially loaded file.
+		return;
+	}
+
 	if (im->fileName.isNull())
 	{
 		saveAs();
 	}
-	else
+	else if (!im->lossyDecode
+	         || QMessageBox::warning(this, tr("File Is Not Valid UTF-8"),
+	                                 tr("Some bytes of this file are not valid UTF-8 and are shown as replacement "
+	                                    "characters. Saving writes those characters over the original bytes. "
+	                                    "Save anyway?"),
+	                                 QMessageBox::Save | QMessageBox::Cancel)
+	                == QMessageBox::Save)
 	{
-		QFile fileLoc(im->fileName);
-		if (fileLoc.open(QIODeviceBase::WriteOnly | QIODeviceBase::Truncate))
-		{
-			QTextStream out(&fileLoc);
-			out << im->ui.mainEdit->toPlainText();
-			im->document->setModified(false);
-			im->modCheck = false;
-			im->updateFileDisplay();
-		}
-		else
-		{
-			QMessageBox::critical(this, tr("File Failed to Save"),
-			                      tr("Saving the currently open file failed, the reason was not diagnosed."));
-		}
+		im->startSave(im->fileName);
 	}
 }
 
 void MainWindow::pageSetup()
 {
-	im->psDialog.open();
+	im->pageSetupDialog().open();
 }
 
 void MainWindow::printDialog()
 {
-	im->pDialog.open(this, SLOT(print()));
+	im->printDialog().open(this, SLOT(print()));
+}
+
+void MainWindow::exportPdf()
+{
+	const QString filename = QFileDialog::getSaveFileName(this, tr("Export as PDF"), QString(),
+	                                                      tr("PDF Files (*.pdf)"));
+	if (filename.isNull() || im->printJob)
+	{
+		return;
+	}
+
+	// Pages are laid out the way page setup says, the same as they would be printed.
+	im->pdfName = filename;
+	im->pdfWriter = std::make_unique<QPdfWriter>(filename);
+	im->pdfWriter->setPageLayout(im->printer().pageLayout());
+	im->pdfWriter->setTitle(im->fileName.isEmpty() ? tr("Untitled") : im->fileName.section('/', -1));
+	im->startPrint(im->pdfWriter.get());
 }
 
 void MainWindow::deleteText()
 {
-	im->ui.mainEdit->textCursor().deleteChar();
+	if (im->ui.mainEdit->isReadOnly())
+	{
+		return;
+	}
+
+	QTextCursor cursor = im->ui.mainEdit->textCursor();
+	im->ui.mainEdit->prepareEdit(cursor);
+	cursor.deleteChar();
 }
 
 void MainWindow::find()
@@ -352,19 +1501,120 @@ void MainWindow::replace()
 	im->openFindReplace(false);
 }
 
+void MainWindow::goToLine()
+{
+	const qint64 lines = im->ui.mainEdit->lineCount();
+	if (lines < 0)
+	{
+		im->ui.statusbar->showMessage(tr("Line numbers are still being counted."), 3000);
+		return;
+	}
+
+	const int last = int(std::min<qint64>(lines, std::numeric_limits<int>::max()));
+	const int current = int(std::clamp<qint64>(im->ui.mainEdit->cursorLine() + 1, 1, last));
+	bool ok = false;
+	const int line = QInputDialog::getInt(this, tr("Go To Line"), tr("Line number:"), current, 1, last, 1, &ok);
+	if (ok)
+	{
+		im->ui.mainEdit->goToLine(line - 1);
+	}
+}
+
 void MainWindow::timeDate()
 {
-	im->ui.mainEdit->textCursor().insertText(QDateTime::currentDateTime().toString(tr("hh:mm M/d/yyyy")));
+	if (im->ui.mainEdit->isReadOnly())
+	{
+		return;
+	}
+
+	QTextCursor cursor = im->ui.mainEdit->textCursor();
+	im->ui.mainEdit->prepareEdit(cursor);
+	cursor.insertText(QDateTime::currentDateTime().toString(tr("hh:mm M/d/yyyy")));
+}
+
+void MainWindow::showUndoMemory()
+{
+	UndoHistory const &history = im->ui.mainEdit->undoHistory();
+	const QLocale locale;
+	//: Shown in the status bar, %1 and %2 are sizes such as 1.5 MiB and the rest are numbers of undo steps.
+	const QString message = tr("Undo history: %1 of %2, %3 steps to undo, %4 to redo, %5 dropped")
+	                            .arg(locale.formattedDataSize(history.memoryUsed()),
+	                                 locale.formattedDataSize(history.budget()))
+	                            .arg(history.undoSteps())
+	                            .arg(history.redoSteps())
+	                            .arg(history.droppedSteps());
+	// The message would go unseen with the status bar hidden.
+	im->ui.action_Status_Bar->setChecked(true);
+	im->ui.statusbar->showMessage(message, MESSAGE_TIME);
+}
+
+void MainWindow::convertToLf()
+{
+	im->convertLineEndings(LineEndings::Lf);
+}
+
+void MainWindow::convertToCrLf()
+{
+	im->convertLineEndings(LineEndings::CrLf);
+}
+
+void MainWindow::convertToCr()
+{
+	im->convertLineEndings(LineEndings::Cr);
+}
+
+void MainWindow::lineEndingsCounted()
+{
+	// Counting only ever covers the mapped file, a conversion since is what it will be saved with.
+	if (std::optional<LineEndings> counted = im->ui.mainEdit->lineEndings(); counted && !im->lineEndingConverted)
+	{
+		im->setLineEndings(*counted);
+	}
 }
 
 void MainWindow::wordWrap(bool checked)
 {
-	im->ui.mainEdit->setLineWrapMode(checked ? QPlainTextEdit::WidgetWidth : QPlainTextEdit::NoWrap);
+	im->ui.mainEdit->setWrapping(checked);
+}
+
+void MainWindow::followFile(bool checked)
+{
+	if (!checked)
+	{
+		im->stopFollowing();
+		return;
+	}
+
+	if (im->follower)
+	{
+		return;
+	}
+
+	QString reason;
+	if (im->fileName.isEmpty() || im->loader)
+	{
+		reason = tr("Only a file that has been opened can be followed.");
+	}
+	else if (im->document->isModified())
+	{
+		reason = tr("Save or undo the changes before following the file.");
+	}
+
+	if (!reason.isEmpty())
+	{
+		im->ui.statusbar->showMessage(reason, 3000);
+		im->ui.actionFollow_File->setChecked(false);
+		return;
+	}
+
+	im->startFollowing();
+	// Following starts at the end, the way tail -f does.
+	im->ui.mainEdit->scrollToEnd();
 }
 
 void MainWindow::fontDialog()
 {
-	im->fDialog.open(this, SLOT(fontChanged(QFont const&)));
+	im->fontDialog().open(this, SLOT(fontChanged(QFont const&)));
 }
 
 void MainWindow::onlineHelp()
@@ -374,11 +1624,15 @@ void MainWindow::onlineHelp()
 
 void MainWindow::aboutDialog()
 {
-	im->about.show();
+	im->aboutDialog().show();
 }
 
 void MainWindow::textChanged()
 {
+	// A search of the old text would report positions that no longer mean anything.
+	im->search.cancel();
+	im->searchText.clear();
+	im->searchTextValid = false;
 	if (im->modCheck != im->document->isModified())
 	{
 		im->modCheck = im->document->isModified();
@@ -386,6 +1640,69 @@ void MainWindow::textChanged()
 	}
 }
 
+void MainWindow::recoverEdits()
+{
+	std::vector<EditJournal::Orphan> orphans = EditJournal::orphans();
+	for (EditJournal::Orphan &orphan : orphans)
+	{
+		const QString name = orphan.fileName.isEmpty() ? tr("Untitled") : orphan.fileName;
+		if (orphan.edits.empty())
+		{
+			EditJournal::remove(orphan);
+		}
+		else if (orphan.fileChanged)
+		{
+			QMessageBox::warning(this, tr("Unsaved Edits Lost"),
+			                     tr("The editor closed without saving the edits to %1, and the file has changed since, "
+			                        "so they can no longer be recovered.").arg(name));
+			EditJournal::remove(orphan);
+		}
+		else if (QMessageBox::question(this, tr("Recover Unsaved Edits"),
+		                               tr("The editor closed without saving the edits to %1. Recover them?").arg(name))
+		         == QMessageBox::Yes)
+		{
+			MainWindow *window = im->isPristine() ? this : openWindow();
+			window->im->recover(std::move(orphan));
+		}
+		else
+		{
+			EditJournal::remove(orphan);
+		}
+	}
+}
+
+void MainWindow::documentEdited(int position, int charsRemoved, int charsAdded)
+{
+	if (!im->journal || im->ui.mainEdit->isWindowed())
+	{
+		return;
+	}
+
+	// The reported range can overshoot the end of the document, on either side of the edit.
+	const int chars = im->document->characterCount();
+	charsRemoved = std::clamp(charsRemoved, 0, std::max(0, im->journalChars - 1 - position));
+	charsAdded = std::clamp(charsAdded, 0, std::max(0, chars - 1 - position));
+	im->journalChars = chars;
+	QTextCursor span(im->document);
+	span.setPosition(position);
+	span.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+	const QString inserted = span.selectedText().replace(QChar::ParagraphSeparator, QChar('\n'));
+	im->journal->record(position, charsRemoved, inserted.toUtf8());
+}
+
+void MainWindow::bufferEdited(qint64 offset, qint64 removed, QByteArray const &inserted)
+{
+	if (im->journal)
+	{
+		im->journal->record(offset, removed, inserted);
+	}
+
+	if (im->savingOver)
+	{
+		im->editsDuringSave.push_back({ offset, removed, inserted });
+	}
+}
+
 void MainWindow::cursorMoved()
 {
 	im->updateLineColLabel();
@@ -408,14 +1725,220 @@ void MainWindow::restoreZoom()
 
 void MainWindow::print()
 {
-	im->document->print(&im->filePrinter);
+	if (im->printJob)
+	{
+		return;
+	}
+
+	QPrinter &printer = im->printer();
+	const bool range = printer.printRange() == QPrinter::PageRange;
+	im->startPrint(&printer, range ? printer.fromPage() : 0, range ? printer.toPage() : 0);
+}
+
+void MainWindow::printProgress(qint64 done, qint64 total)
+{
+	if (sender() == im->printJob && total > 0)
+	{
+		im->printBar.setValue(int(done * 1000 / total));
+	}
+}
+
+void MainWindow::printFinished()
+{
+	if (sender() != im->printJob)
+	{
+		return;
+	}
+
+	im->endPrint();
+	if (im->saveHeld)
+	{
+		im->finishSave();
+	}
+}
+
+void MainWindow::cancelTask()
+{
+	if (im->loader)
+	{
+		cancelLoad();
+	}
+	else if (im->printJob)
+	{
+		im->printJob->cancel();
+	}
 }
 
 void MainWindow::fontChanged(const QFont &font)
 {
-	im->document->setDefaultFont(font);
+	im->zoomTimer.stop();
+	im->ui.mainEdit->setDocumentFont(font);
 	im->generateSlideRule();
 	im->currentZoom = DEFAULT_ZOOM;
+	im->updateZoomLabel();
+}
+
+void MainWindow::applyZoom()
+{
+	im->applyZoom();
+}
+
+void MainWindow::pumpSave()
+{
+	im->pumpSave(false);
+}
+
+void MainWindow::saveFinished()
+{
+	if (sender() == im->saver)
+	{
+		if (im->savingOver && im->printJob)
+		{
+			im->saveHeld = true;
+			return;
+		}
+
+		im->finishSave();
+	}
+}
+
+void MainWindow::loadBatch(QString const &text)
+{
+	// Batches of a load that has since been cancelled may still be queued.
+	if (sender() == im->loader)
+	{
+		QTextCursor end(im->document);
+		end.movePosition(QTextCursor::End);
+		end.insertText(text);
+		im->setEncoding(im->loader->encoding());
+		im->document->setModified(false);
+		im->loader->batchConsumed();
+	}
+}
+
+void MainWindow::loadProgress(qint64 done, qint64 total)
+{
+	if (sender() == im->loader)
+	{
+		im->loadedBytes = done;
+		if (total > 0)
+		{
+			im->loadBar.setValue(int(done * 1000 / total));
+		}
+	}
+}
+
+void MainWindow::loadFinished()
+{
+	if (sender() == im->loader)
+	{
+		im->setLineEndings(im->loader->lineEndings());
+		im->lossyDecode = im->loader->isLossy();
+		im->stopLoad();
+		im->document->setModified(false);
+		im->modCheck = false;
+		im->updateFileDisplay();
+		im->startJournal();
+		im->applyRecovered();
+	}
+}
+
+void MainWindow::loadFailed()
+{
+	if (sender() == im->loader)
+	{
+		im->stopLoad();
+		im->fileName.clear();
+		im->document->setPlainText("");
+		im->updateFileDisplay();
+		im->recovered.reset();
+		im->startJournal();
+		QMessageBox::critical(this, tr("File Failed to Open"),
+		                      tr("Opening the selected file failed, the reason was not diagnosed."));
+	}
+}
+
+void MainWindow::followAppended(QString const &text)
+{
+	if (sender() != im->follower.get())
+	{
+		return;
+	}
+
+	// The view only keeps scrolling along while it is at the end, so whoever scrolled up to read stays where they are.
+	// Only the new blocks are laid out, everything above them is left as it is.
+	QScrollBar *bar = im->ui.mainEdit->verticalScrollBar();
+	const bool atEnd = bar->value() == bar->maximum();
+	QTextCursor end(im->document);
+	end.movePosition(QTextCursor::End);
+	end.insertText(text);
+	im->document->setModified(false);
+	if (atEnd)
+	{
+		bar->setValue(bar->maximum());
+	}
+
+	// A document that grew as large as a file that would have been mapped from the start goes over to a mapping.
+	if (!im->followMapped && im->follower->offset() >= LARGE_FILE_THRESHOLD && im->followMapping())
+	{
+		im->ui.statusbar->showMessage(tr("The file grew large, it is now shown in parts as it is scrolled."), 3000);
+	}
+}
+
+void MainWindow::followBytesAppended(QByteArray const &bytes)
+{
+	if (sender() == im->follower.get())
+	{
+		im->ui.mainEdit->appendToBuffer(bytes);
+		im->document->setModified(false);
+	}
+}
+
+void MainWindow::followRestarted()
+{
+	if (sender() == im->follower.get())
+	{
+		// A mapping of a file that shrank cannot be read past its new end, so the file is mapped again as it is now.
+		if (!im->ui.mainEdit->isWindowed() || !im->followMapping())
+		{
+			im->ui.mainEdit->closeBuffer();
+			im->follower->setRaw(false);
+			im->document->setPlainText("");
+		}
+
+		im->document->setModified(false);
+		im->ui.statusbar->showMessage(tr("The file was truncated or replaced, following it from the start."), 3000);
+	}
+}
+
+void MainWindow::openFiles(QStringList const &files)
+{
+	if (files.isEmpty())
+	{
+		openWindow();
+	}
+
+	for (QString const &file : files)
+	{
+		openWindow()->loadFile(file);
+	}
+}
+
+void MainWindow::cancelLoad()
+{
+	if (im->loader)
+	{
+		// A partially loaded file must never be saved back over the original, so cancelling leaves an empty document.
+		im->stopLoad();
+		im->fileName.clear();
+		im->document->setPlainText("");
+		im->document->setModified(false);
+		im->modCheck = false;
+		im->updateFileDisplay();
+		im->recovered.reset();
+		im->startJournal();
+		im->ui.statusbar->showMessage(tr("Loading cancelled."), 5000);
+	}
 }
 
 void MainWindow::doFindRequest(FindFlags flags, const QString &seek)
@@ -424,15 +1947,29 @@ void MainWindow::doFindRequest(FindFlags flags, const QString &seek)
 	{
 		emit nothingToFind();
 	}
+
+	matchesChanged();
 }
 
 void MainWindow::doReplaceRequest(FindFlags flags, const QString &seek, const QString &replace)
 {
+	// Loading and saving both hold the document read-only, which cursor edits would otherwise ignore.
+	if (im->ui.mainEdit->isReadOnly())
+	{
+		return;
+	}
+
 	QTextCursor current = im->ui.mainEdit->textCursor();
 	bool reportFail = true;
 	if (current.hasSelection())
 	{
-		current.insertText(replace);
+		TextSearcher searcher(flags, seek);
+		searcher.setReplacement(replace);
+		const QTextBlock block = im->document->findBlock(current.selectionStart());
+		const int start = current.selectionStart() - block.position();
+		const int length = current.selectionEnd() - current.selectionStart();
+		im->ui.mainEdit->prepareEdit(current);
+		current.insertText(searcher.replacementFor(block.text(), start, length));
 		reportFail = false;
 	}
 
@@ -444,23 +1981,83 @@ void MainWindow::doReplaceRequest(FindFlags flags, const QString &seek, const QS
 
 void MainWindow::doReplaceAllRequest(FindFlags flags, const QString &seek, const QString &replace)
 {
-	QTextCursor atFront = im->ui.mainEdit->textCursor();
-	atFront.setPosition(0);
-	bool found = false;
-	// Replace All does not want to wrap around, so ignore if the user has it set.
-	flags.set(4, false);
-	while (!(atFront = im->findNext(flags, seek, atFront)).isNull())
+	if (im->ui.mainEdit->isReadOnly())
 	{
-		found = true;
-		atFront.insertText(replace);
+		return;
 	}
 
-	if (!found)
+	if (!im->replaceAll(flags, seek, replace))
 	{
 		emit nothingToFind();
 	}
 }
 
+void MainWindow::doIncrementalSearch(FindFlags flags, const QString &seek)
+{
+	if (!im->matches->covers(flags, seek))
+	{
+		im->matches->clear();
+	}
+
+	// Searching from the start of the current match means it stays put while the search text is being extended.
+	const QTextCursor current = im->ui.mainEdit->textCursor();
+	const int from = flags.test(0) ? current.selectionEnd() : current.selectionStart();
+	im->searchInBuffer = im->ui.mainEdit->isWindowed() && !flags.test(3);
+	if (im->searchInBuffer)
+	{
+		im->search.start(flags, seek, *im->ui.mainEdit->buffer(), im->ui.mainEdit->offsetOf(from));
+	}
+	else
+	{
+		im->search.start(flags, seek, im->documentText(), from);
+	}
+}
+
+void MainWindow::cancelIncrementalSearch()
+{
+	im->search.cancel();
+}
+
+void MainWindow::incrementalFound(qint64 start, qint64 length)
+{
+	if (im->searchInBuffer)
+	{
+		im->ui.mainEdit->setTextCursor(im->ui.mainEdit->selectionAt(start, length));
+		return;
+	}
+
+	QTextCursor select(im->document);
+	select.setPosition(int(start));
+	select.setPosition(int(start + length), QTextCursor::KeepAnchor);
+	im->ui.mainEdit->setTextCursor(select);
+}
+
+void MainWindow::matchesChanged()
+{
+	im->highlightMatches(true);
+	// A window only holds part of the file, so a count of its matches would be misleading.
+	if (im->ui.mainEdit->isWindowed())
+	{
+		emit matchCountChanged(0, -1);
+		return;
+	}
+
+	QTextCursor current = im->ui.mainEdit->textCursor();
+	const int index = current.hasSelection() ? im->matches->indexOf(current.selectionStart(), current.selectionEnd())
+	                                         : -1;
+	emit matchCountChanged(index + 1, im->matches->count());
+}
+
+void MainWindow::viewUpdated()
+{
+	im->highlightMatches(false);
+}
+
+void MainWindow::clearMatches()
+{
+	im->matches->clear();
+}
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
 	if (im->editedCheck())
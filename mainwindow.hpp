@@ -32,8 +32,14 @@ public:
 	MainWindow(QWidget *parent = nullptr);
 	~MainWindow();
 
+	// Opens the file in the background, the way Open does once a file has been picked.
+	void loadFile(QString const &filename);
+	// Offers back the edits of sessions that ended without saving them, each in a window of its own.
+	void recoverEdits();
+
 signals:
 	void nothingToFind();
+	void matchCountChanged(int current, int total);
 
 public slots:
 	void newFile();
@@ -43,15 +49,25 @@ public slots:
 	void saveFile();
 	void pageSetup();
 	void printDialog();
+	void exportPdf();
 
 	void deleteText();
 
 	void find();
 	void replace();
+	void goToLine();
 
 	void timeDate();
+	// Tells in the status bar how much memory the undo history takes up.
+	void showUndoMemory();
+
+	void convertToLf();
+	void convertToCrLf();
+	void convertToCr();
+	void lineEndingsCounted();
 
 	void wordWrap(bool checked);
+	void followFile(bool checked);
 	void fontDialog();
 
 	void onlineHelp();
@@ -64,14 +80,47 @@ public slots:
 	void zoomOut();
 	void restoreZoom();
 
+	void cancelLoad();
+
+	// Opens each file in a window of its own, or an empty window when there are none.
+	void openFiles(QStringList const &files);
+
 private slots:
 	void print();
+	void printProgress(qint64 done, qint64 total);
+	void printFinished();
+	// Escape cancels a load if there is one, and a print job otherwise.
+	void cancelTask();
 	void fontChanged(QFont const &font);
+	void applyZoom();
+
+	void pumpSave();
+	void saveFinished();
+
+	void loadBatch(QString const &text);
+	void loadProgress(qint64 done, qint64 total);
+	void loadFinished();
+	void loadFailed();
+
+	void followAppended(QString const &text);
+	void followBytesAppended(QByteArray const &bytes);
+	void followRestarted();
+
+	void documentEdited(int position, int charsRemoved, int charsAdded);
+	void bufferEdited(qint64 offset, qint64 removed, QByteArray const &inserted);
 
 	void doFindRequest(FindFlags flags, QString const &seek);
 	void doReplaceRequest(FindFlags flags, QString const &seek, QString const &replace);
 	void doReplaceAllRequest(FindFlags flags, QString const &seek, QString const &replace);
 
+	void doIncrementalSearch(FindFlags flags, QString const &seek);
+	void cancelIncrementalSearch();
+	void incrementalFound(qint64 start, qint64 length);
+
+	void matchesChanged();
+	void viewUpdated();
+	void clearMatches();
+
 protected:
 	void closeEvent(QCloseEvent *event) override;
 
@@ -0,0 +1,85 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** mappedfile.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "mappedfile.hpp"
+
+MappedFile::MappedFile(QString const &fileName) :
+    file(fileName),
+    mapping(nullptr),
+    length(0),
+    opened(false)
+{
+	if (file.open(QIODeviceBase::ReadOnly))
+	{
+		length = file.size();
+		// Mapping a zero length file fails on most platforms, but an empty file is still a valid file.
+		mapping = length > 0 ? file.map(0, length) : nullptr;
+		opened = length == 0 || mapping != nullptr;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	release();
+}
+
+bool MappedFile::isOpen() const
+{
+	return opened;
+}
+
+QString MappedFile::fileName() const
+{
+	return file.fileName();
+}
+
+const char *MappedFile::data() const
+{
+	return reinterpret_cast<const char *>(mapping);
+}
+
+qint64 MappedFile::size() const
+{
+	return length;
+}
+
+void MappedFile::release()
+{
+	if (mapping)
+	{
+		file.unmap(mapping);
+		mapping = nullptr;
+	}
+
+	file.close();
+}
+
+bool MappedFile::reopen()
+{
+	if (!opened || mapping || length == 0)
+	{
+		return opened;
+	}
+
+	if (file.open(QIODeviceBase::ReadOnly) && file.size() == length)
+	{
+		mapping = file.map(0, length);
+	}
+
+	return mapping != nullptr;
+}
@@ -0,0 +1,48 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** mappedfile.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+class MappedFile
+{
+public:
+	explicit MappedFile(QString const &fileName);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	bool isOpen() const;
+	QString fileName() const;
+	const char *data() const;
+	qint64 size() const;
+
+	// Windows refuses to replace a file that is mapped, so saving over it lets go of the mapping first.  Nothing may
+	// read the data in between, and reopen() maps the same length of the file again if the save failed after all.
+	void release();
+	bool reopen();
+
+private:
+	QFile file;
+	uchar *mapping;
+	qint64 length;
+	bool opened;
+};
@@ -0,0 +1,305 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** matchindex.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "matchindex.hpp"
+
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+#include "textsearcher.hpp"
+
+namespace
+{
+// Only the bits that change what matches, not where the search goes next.
+constexpr FindFlags MATCH_FLAGS = FFlags::FindCaseSensitively | FFlags::FindWholeWords | FFlags::FindByRegex;
+// Milliseconds the scan of a new search runs for before it lets the events waiting in the meantime through.
+constexpr int SCAN_SLICE = 8;
+}
+
+struct MatchIndex::Impl
+{
+	Impl(QTextDocument *document) :
+	    document(document)
+	{
+		// No implementation.
+	}
+
+	// Matches of the blocks from first to last inclusive.  Empty matches of a regex are left out, there is nothing to
+	// select or highlight for them.
+	std::vector<Match> scan(QTextBlock first, QTextBlock const &last) const
+	{
+		std::vector<Match> found;
+		for (QTextBlock block = first; block.isValid(); block = block.next())
+		{
+			scanBlock(block, found);
+			if (block == last)
+			{
+				break;
+			}
+		}
+
+		return found;
+	}
+
+	void scanBlock(QTextBlock const &block, std::vector<Match> &found) const
+	{
+		const int base = block.position();
+		searcher->forEachMatch(block.text(), [&found, base](qsizetype start, qsizetype length) {
+			if (length > 0)
+			{
+				found.push_back({ base + int(start), int(length) });
+			}
+
+			return true;
+		});
+	}
+
+	void reset(std::vector<Match> found)
+	{
+		matches = std::move(found);
+		gapBegin = gapEnd = matches.size();
+		shift = 0;
+	}
+
+	size_t count() const
+	{
+		return matches.size() - (gapEnd - gapBegin);
+	}
+
+	Match at(size_t index) const
+	{
+		if (index < gapBegin)
+		{
+			return matches[index];
+		}
+
+		Match match = matches[index + (gapEnd - gapBegin)];
+		match.start += shift;
+		return match;
+	}
+
+	size_t lowerBound(int position) const
+	{
+		size_t low = 0, high = count();
+		while (low < high)
+		{
+			const size_t middle = low + (high - low) / 2;
+			if (at(middle).start < position)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+
+		return low;
+	}
+
+	// Moves the gap to the given index.  The matches it passes over go from holding their position to holding it less
+	// the shift, or back again.
+	void moveGap(size_t index)
+	{
+		while (gapBegin > index)
+		{
+			matches[--gapEnd] = matches[--gapBegin];
+			matches[gapEnd].start -= shift;
+		}
+
+		while (gapBegin < index)
+		{
+			matches[gapBegin] = matches[gapEnd++];
+			matches[gapBegin++].start += shift;
+		}
+	}
+
+	// Puts found in place of the matches from begin up to end, and moves everything after them along by delta.
+	void replace(size_t begin, size_t end, int delta, std::vector<Match> const &found)
+	{
+		moveGap(begin);
+		gapEnd += end - begin;
+		shift += delta;
+		if (gapEnd - gapBegin < found.size())
+		{
+			// Growing by half of what there is keeps making room amortized constant per match.
+			const size_t room = found.size() + matches.size() / 2;
+			matches.insert(matches.begin() + std::ptrdiff_t(gapEnd), room - (gapEnd - gapBegin), Match {});
+			gapEnd = gapBegin + room;
+		}
+
+		for (Match const &match : found)
+		{
+			matches[gapBegin++] = match;
+		}
+	}
+
+	QTextDocument *document;
+	std::optional<TextSearcher> searcher;
+	FindFlags flags;
+	QString seek;
+	// The matches in order, with a gap where the last edit was.  Those after the gap hold their start less shift, so an
+	// edit moves all of them along at once and only the matches between it and the edit before pass the gap.
+	std::vector<Match> matches;
+	size_t gapBegin = 0;
+	size_t gapEnd = 0;
+	int shift = 0;
+	// Start of the first block the scan of the search has not got to yet, which is kept up with edits made before it.
+	int scanned = 0;
+	QTimer scanTimer;
+};
+
+MatchIndex::MatchIndex(QTextDocument *document, QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<MatchIndex::Impl>(document))
+{
+	QObject::connect(document, SIGNAL(contentsChange(int,int,int)), this, SLOT(documentChanged(int,int,int)));
+	im->scanTimer.setSingleShot(true);
+	im->scanTimer.setInterval(0);
+	QObject::connect(&im->scanTimer, SIGNAL(timeout()), this, SLOT(scanSlice()));
+}
+
+MatchIndex::~MatchIndex()
+{
+	// No implementation.
+}
+
+bool MatchIndex::covers(FindFlags flags, QString const &seek) const
+{
+	return im->searcher && (flags & MATCH_FLAGS) == im->flags && seek == im->seek;
+}
+
+void MatchIndex::setSearch(FindFlags flags, QString const &seek)
+{
+	if (covers(flags, seek))
+	{
+		return;
+	}
+
+	im->flags = flags & MATCH_FLAGS;
+	im->seek = seek;
+	im->searcher.emplace(im->flags, seek);
+	im->reset({});
+	im->scanned = 0;
+	im->scanTimer.start();
+	emit changed();
+}
+
+void MatchIndex::clear()
+{
+	if (im->searcher)
+	{
+		im->searcher.reset();
+		im->seek.clear();
+		im->reset({});
+		im->scanTimer.stop();
+		emit changed();
+	}
+}
+
+bool MatchIndex::isComplete() const
+{
+	return !im->scanTimer.isActive();
+}
+
+int MatchIndex::count() const
+{
+	return int(im->count());
+}
+
+MatchIndex::Match MatchIndex::at(int index) const
+{
+	return im->at(size_t(index));
+}
+
+int MatchIndex::lowerBound(int position) const
+{
+	return int(im->lowerBound(position));
+}
+
+int MatchIndex::indexOf(int start, int end) const
+{
+	const int index = lowerBound(start);
+	if (index < count() && at(index).start == start && at(index).start + at(index).length == end)
+	{
+		return index;
+	}
+
+	return -1;
+}
+
+void MatchIndex::documentChanged(int position, int charsRemoved, int charsAdded)
+{
+	if (!im->searcher)
+	{
+		return;
+	}
+
+	// Matches never cross a block boundary, so rescanning every block the change touched is enough.  In the old text
+	// those blocks spanned [from, to - delta), everything after them only moved.
+	QTextDocument *doc = im->document;
+	const QTextBlock first = doc->findBlock(position);
+	const QTextBlock last = doc->findBlock(std::min(position + charsAdded, doc->characterCount() - 1));
+	const int from = first.position();
+	const int to = last.position() + last.length();
+	const int delta = charsAdded - charsRemoved;
+	if (from >= im->scanned)
+	{
+		// The scan has not got this far yet, and finds the matches here once it does.
+		return;
+	}
+
+	const size_t begin = im->lowerBound(from);
+	const size_t end = im->lowerBound(to - delta);
+	im->replace(begin, end, delta, im->scan(first, last));
+	im->scanned = std::max(im->scanned + delta, to);
+	emit changed();
+}
+
+void MatchIndex::scanSlice()
+{
+	if (!im->searcher)
+	{
+		return;
+	}
+
+	QElapsedTimer clock;
+	clock.start();
+	std::vector<Match> found;
+	QTextBlock block = im->document->findBlock(im->scanned);
+	while (block.isValid() && clock.elapsed() < SCAN_SLICE)
+	{
+		im->scanBlock(block, found);
+		block = block.next();
+	}
+
+	im->scanned = block.isValid() ? block.position() : im->document->characterCount();
+	im->replace(im->count(), im->count(), 0, found);
+	if (block.isValid())
+	{
+		im->scanTimer.start();
+	}
+
+	emit changed();
+}
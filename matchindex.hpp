@@ -0,0 +1,71 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** matchindex.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QObject>
+
+#include <memory>
+
+#include "findflags.hpp"
+
+class QTextDocument;
+
+// Every match of one search within a document, kept sorted and up to date as the document is edited.  A new search is
+// scanned a slice at a time in between events, an edit only rescans the blocks it touched, the matches after it are
+// moved along all at once.
+class MatchIndex : public QObject
+{
+	Q_OBJECT
+
+public:
+	struct Match
+	{
+		int start;
+		int length;
+	};
+
+	explicit MatchIndex(QTextDocument *document, QObject *parent = nullptr);
+	~MatchIndex();
+
+	// Whether the index holds the matches of this search, the direction and wrapping do not matter.
+	bool covers(FindFlags flags, QString const &seek) const;
+	void setSearch(FindFlags flags, QString const &seek);
+	void clear();
+	// Whether the scan of the search got through the document.  Until then only the matches before where it got to are
+	// held, and changed() is emitted as it goes on.
+	bool isComplete() const;
+
+	int count() const;
+	Match at(int index) const;
+	// Index of the first match starting at or after the position, or count() if there is none.
+	int lowerBound(int position) const;
+	// Index of the match covering exactly the given range, or -1.
+	int indexOf(int start, int end) const;
+
+signals:
+	void changed();
+
+private slots:
+	void documentChanged(int position, int charsRemoved, int charsAdded);
+	void scanSlice();
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
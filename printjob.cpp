@@ -0,0 +1,286 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** printjob.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "printjob.hpp"
+
+#include <QFont>
+#include <QFontMetricsF>
+#include <QPagedPaintDevice>
+#include <QPainter>
+#include <QPrinter>
+#include <QStringDecoder>
+#include <QTextLayout>
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+
+#include "textbuffer.hpp"
+
+// Amount of the snapshot laid out between progress reports and checks for cancellation.
+constexpr qint64 PRINT_SLICE = 64 << 10;
+// Tab stops are this many average characters apart.
+constexpr int PRINT_TAB_WIDTH = 8;
+
+struct PrintJob::Impl
+{
+	Impl(QPagedPaintDevice *device, QFont const &font) :
+	    device(device),
+	    font(font, device)
+	{
+		// No implementation.
+	}
+
+	bool stopped() const
+	{
+		return cancelled || (lastPage > 0 && page > lastPage);
+	}
+
+	bool wanted() const
+	{
+		return page >= firstPage && (lastPage == 0 || page <= lastPage);
+	}
+
+	void start()
+	{
+		const QFontMetricsF metrics(font, device);
+		option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+		option.setTabStopDistance(metrics.averageCharWidth() * PRINT_TAB_WIDTH);
+		// The bottom two lines of every page are kept for its number.
+		footer = metrics.lineSpacing() * 2;
+		width = device->width();
+		height = std::max<qreal>(metrics.lineSpacing(), device->height() - footer);
+		painter.setFont(font);
+	}
+
+	// The device starts out on its first page, every page painted after that has to be asked for.
+	void openPage()
+	{
+		if (openedPage != page)
+		{
+			if (openedPage > 0)
+			{
+				device->newPage();
+			}
+
+			openedPage = page;
+		}
+	}
+
+	void closePage()
+	{
+		if (openedPage == page)
+		{
+			painter.drawText(QRectF(0, height, width, footer), Qt::AlignRight | Qt::AlignBottom, QString::number(page));
+			++printed;
+		}
+	}
+
+	void printLine(QString const &line)
+	{
+		QTextLayout layout(line, font, device);
+		layout.setTextOption(option);
+		layout.beginLayout();
+		for (QTextLine row = layout.createLine(); row.isValid(); row = layout.createLine())
+		{
+			row.setLineWidth(width);
+		}
+
+		layout.endLayout();
+		for (int i = 0; i < layout.lineCount() && !stopped(); ++i)
+		{
+			const QTextLine row = layout.lineAt(i);
+			if (y > 0 && y + row.height() > height)
+			{
+				closePage();
+				++page;
+				y = 0;
+				if (stopped())
+				{
+					break;
+				}
+			}
+
+			if (wanted())
+			{
+				openPage();
+				row.draw(&painter, QPointF(0, y - row.y()));
+			}
+
+			y += row.height();
+		}
+	}
+
+	// Breaks are \n, \r\n or a lone \r, and either half of a \r\n pair may end a slice.  The raw text of a document
+	// separates its blocks with paragraph separators instead.
+	void feed(QStringView slice)
+	{
+		qsizetype lineStart = 0;
+		for (qsizetype i = 0; i < slice.size() && !stopped(); ++i)
+		{
+			const QChar c = slice[i];
+			if (afterCr)
+			{
+				afterCr = false;
+				if (c == QChar('\n'))
+				{
+					lineStart = i + 1;
+					continue;
+				}
+			}
+
+			if (c == QChar('\n') || c == QChar('\r') || c == QChar::ParagraphSeparator)
+			{
+				partial += slice.mid(lineStart, i - lineStart);
+				printLine(partial);
+				partial.clear();
+				lineStart = i + 1;
+				afterCr = c == QChar('\r');
+			}
+		}
+
+		partial += slice.mid(lineStart);
+	}
+
+	QPagedPaintDevice *device;
+	QFont font;
+	QString text;
+	std::optional<TextBuffer> buffer;
+	int firstPage = 0;
+	int lastPage = 0;
+	std::atomic<bool> cancelled { false };
+	bool ok = false;
+	QPainter painter;
+	QTextOption option;
+	qreal width = 0;
+	qreal height = 0;
+	qreal footer = 0;
+	qreal y = 0;
+	int page = 1;
+	int openedPage = 0;
+	int printed = 0;
+	QString partial;
+	bool afterCr = false;
+};
+
+PrintJob::PrintJob(QPagedPaintDevice *device, QFont const &font, QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<PrintJob::Impl>(device, font))
+{
+	// No implementation.
+}
+
+PrintJob::~PrintJob()
+{
+	// No implementation.
+}
+
+void PrintJob::setText(QString const &text)
+{
+	im->text = text;
+}
+
+void PrintJob::setBuffer(TextBuffer const &snapshot)
+{
+	im->buffer.emplace(snapshot);
+}
+
+void PrintJob::setPageRange(int first, int last)
+{
+	im->firstPage = first;
+	im->lastPage = last;
+}
+
+void PrintJob::cancel()
+{
+	im->cancelled = true;
+}
+
+bool PrintJob::succeeded() const
+{
+	return im->ok;
+}
+
+bool PrintJob::wasCancelled() const
+{
+	return im->cancelled;
+}
+
+int PrintJob::pageCount() const
+{
+	return im->printed;
+}
+
+void PrintJob::run()
+{
+	if (!im->painter.begin(im->device))
+	{
+		emit finished();
+		return;
+	}
+
+	im->start();
+	qint64 done = 0;
+	if (im->buffer)
+	{
+		// Buffers are always UTF-8, and a piece can be as big as the whole file, so it is decoded a slice at a time.
+		const qint64 total = im->buffer->size();
+		QStringDecoder decoder(QStringConverter::Utf8);
+		im->buffer->forEachChunk(0, total, [&](const char *data, qint64 length) {
+			for (qint64 at = 0; at < length && !im->stopped(); at += PRINT_SLICE)
+			{
+				const qint64 count = std::min(PRINT_SLICE, length - at);
+				const QString slice = decoder.decode(QByteArrayView(data + at, count));
+				im->feed(slice);
+				done += count;
+				emit progress(done, total);
+			}
+
+			return !im->stopped();
+		});
+	}
+	else
+	{
+		const qint64 total = im->text.size();
+		for (qint64 at = 0; at < total && !im->stopped(); at += PRINT_SLICE)
+		{
+			const qint64 count = std::min(PRINT_SLICE, total - at);
+			im->feed(QStringView(im->text).mid(at, count));
+			done += count;
+			emit progress(done, total);
+		}
+	}
+
+	if (!im->stopped() && (!im->partial.isEmpty() || im->openedPage == 0))
+	{
+		im->printLine(im->partial);
+	}
+
+	im->closePage();
+	if (im->cancelled)
+	{
+		// A printer drops the pages it was sent, a PDF writer is left to the caller to throw away.
+		if (auto *printer = dynamic_cast<QPrinter *>(im->device))
+		{
+			printer->abort();
+		}
+	}
+
+	im->ok = im->painter.end() && !im->cancelled;
+	emit finished();
+}
@@ -0,0 +1,62 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** printjob.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QObject>
+
+#include <memory>
+
+class QFont;
+class QPagedPaintDevice;
+class TextBuffer;
+
+// Lays text out into pages and paints them onto a printer or PDF writer, on whichever thread it is moved to.  The text
+// is a snapshot, of the document or of a buffer, so editing carries on while it prints.  Pages are painted as they fill
+// up and only the line being laid out is held as a layout, so the cost does not grow with the number of pages.
+class PrintJob : public QObject
+{
+	Q_OBJECT
+
+public:
+	PrintJob(QPagedPaintDevice *device, QFont const &font, QObject *parent = nullptr);
+	~PrintJob();
+
+	// Prints a snapshot of the document, plain or raw text, otherwise one of the buffer.
+	void setText(QString const &text);
+	void setBuffer(TextBuffer const &snapshot);
+	// Only the pages from first to last are painted, both one based and 0 for no limit.
+	void setPageRange(int first, int last);
+
+	// May be called from any thread.
+	void cancel();
+	bool succeeded() const;
+	bool wasCancelled() const;
+	int pageCount() const;
+
+signals:
+	void progress(qint64 done, qint64 total);
+	void finished();
+
+public slots:
+	void run();
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
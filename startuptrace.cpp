@@ -0,0 +1,73 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** startuptrace.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "startuptrace.hpp"
+
+#include <QCoreApplication>
+#include <QEvent>
+
+#include <cstdio>
+
+StartupTrace::StartupTrace(bool enabled) :
+    enabled(enabled)
+{
+	total.start();
+	step.start();
+}
+
+StartupTrace::~StartupTrace()
+{
+	// No implementation.
+}
+
+void StartupTrace::mark(const char *name)
+{
+	if (enabled)
+	{
+		const qint64 elapsed = step.nsecsElapsed();
+		std::fprintf(stderr, "startup: %-16s %9.3f ms\n", name, double(elapsed) / 1e6);
+		step.restart();
+	}
+}
+
+void StartupTrace::markFirstPaint()
+{
+	if (enabled)
+	{
+		qApp->installEventFilter(this);
+	}
+}
+
+bool StartupTrace::eventFilter(QObject *watched, QEvent *event)
+{
+	if (event->type() == QEvent::Paint)
+	{
+		// Paint events are delivered one widget at a time, so the first paint is over once the event loop gets back
+		// to the queue.
+		qApp->removeEventFilter(this);
+		QMetaObject::invokeMethod(this, "painted", Qt::QueuedConnection);
+	}
+
+	return QObject::eventFilter(watched, event);
+}
+
+void StartupTrace::painted()
+{
+	mark("first paint");
+	std::fprintf(stderr, "startup: %-16s %9.3f ms\n", "total", double(total.nsecsElapsed()) / 1e6);
+}
@@ -0,0 +1,49 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** startuptrace.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+
+// Times the steps of starting up and reports them on stderr, for --startup-trace.  Does nothing unless enabled, so it
+// can be created before the command line has been parsed.
+class StartupTrace : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit StartupTrace(bool enabled);
+	~StartupTrace();
+
+	// Reports the time spent since the previous step.
+	void mark(const char *name);
+	// Reports the last step once the first widget has been painted.
+	void markFirstPaint();
+
+protected:
+	bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+	void painted();
+
+private:
+	QElapsedTimer total;
+	QElapsedTimer step;
+	bool enabled;
+};
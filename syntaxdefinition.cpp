@@ -0,0 +1,199 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** syntaxdefinition.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "syntaxdefinition.hpp"
+
+#include <QFileInfo>
+#include <QRegularExpressionMatch>
+
+namespace
+{
+// A double quoted string with backslash escapes, as most formats write them.
+const QString QUOTED = QStringLiteral(R"("(?:[^"\\]|\\.)*")");
+
+std::shared_ptr<SyntaxDefinition const> logDefinition()
+{
+	auto log = std::make_shared<SyntaxDefinition>(QStringLiteral("Log"), QStringList{ "log" });
+	log->addRule(R"(\b(?:\d{4}-\d{2}-\d{2}[T ])?\d{2}:\d{2}:\d{2}(?:[.,]\d+)?(?:Z|[+-]\d{2}:?\d{2})?)",
+	             SyntaxDefinition::Time);
+	log->addRule(R"(\b(?:FATAL|CRITICAL|CRIT|SEVERE|EMERG|ALERT|PANIC|ERROR|ERR)\b)", SyntaxDefinition::Error);
+	log->addRule(R"(\bWARN(?:ING)?\b)", SyntaxDefinition::Warning);
+	log->addRule(R"(\b(?:INFO|NOTICE|DEBUG|TRACE|VERBOSE)\b)", SyntaxDefinition::Info);
+	log->addRule(QUOTED, SyntaxDefinition::String);
+	log->addRule(R"(\b(?:0x[0-9A-Fa-f]+|\d+(?:\.\d+)?)\b)", SyntaxDefinition::Number);
+	return log;
+}
+
+std::shared_ptr<SyntaxDefinition const> jsonDefinition()
+{
+	// Comments are not JSON, but plenty of configuration files written in it have them anyway.
+	auto json = std::make_shared<SyntaxDefinition>(QStringLiteral("JSON"), QStringList{ "json", "jsonc", "geojson" });
+	json->addRule(QUOTED + R"((?=\s*:))", SyntaxDefinition::Key);
+	json->addRule(QUOTED, SyntaxDefinition::String);
+	json->addRule(R"(-?\b\d+(?:\.\d+)?(?:[eE][+-]?\d+)?\b)", SyntaxDefinition::Number);
+	json->addRule(R"(\b(?:true|false|null)\b)", SyntaxDefinition::Keyword);
+	json->addRule(R"(//.*)", SyntaxDefinition::Comment);
+	json->addRegion(R"(/\*)", R"(\*/)", SyntaxDefinition::Comment);
+	return json;
+}
+
+std::shared_ptr<SyntaxDefinition const> iniDefinition()
+{
+	auto ini = std::make_shared<SyntaxDefinition>(QStringLiteral("INI"),
+	                                              QStringList{ "ini", "cfg", "conf", "inf", "desktop", "properties" });
+	ini->addRule(R"(^[ \t]*[;#].*)", SyntaxDefinition::Comment);
+	ini->addRule(R"(^[ \t]*\[[^\]]*\])", SyntaxDefinition::Section);
+	ini->addRule(R"(^[ \t]*\K[^=:;#\s\[][^=:]*?(?=[ \t]*[=:]))", SyntaxDefinition::Key);
+	ini->addRule(QUOTED, SyntaxDefinition::String);
+	ini->addRule(R"(\b(?:true|false|yes|no|on|off)\b)", SyntaxDefinition::Keyword,
+	             QRegularExpression::CaseInsensitiveOption);
+	ini->addRule(R"(\b\d+(?:\.\d+)?\b)", SyntaxDefinition::Number);
+	return ini;
+}
+}
+
+SyntaxDefinition::SyntaxDefinition(QString const &name, QStringList const &suffixes) :
+    title(name),
+    fileSuffixes(suffixes)
+{
+	// No implementation.
+}
+
+std::vector<std::shared_ptr<SyntaxDefinition const>> const &SyntaxDefinition::builtIn()
+{
+	static const std::vector<std::shared_ptr<SyntaxDefinition const>> definitions = {
+		logDefinition(),
+		jsonDefinition(),
+		iniDefinition(),
+	};
+
+	return definitions;
+}
+
+std::shared_ptr<SyntaxDefinition const> SyntaxDefinition::forFile(QString const &fileName)
+{
+	const QString suffix = QFileInfo(fileName).suffix().toLower();
+	for (auto const &definition : builtIn())
+	{
+		if (!suffix.isEmpty() && definition->suffixes().contains(suffix))
+		{
+			return definition;
+		}
+	}
+
+	return nullptr;
+}
+
+QString SyntaxDefinition::name() const
+{
+	return title;
+}
+
+QStringList SyntaxDefinition::suffixes() const
+{
+	return fileSuffixes;
+}
+
+void SyntaxDefinition::addRule(QString const &pattern, Style style, QRegularExpression::PatternOptions options)
+{
+	Rule rule{ QRegularExpression(pattern, options), QRegularExpression(), style };
+	rule.pattern.optimize();
+	rules.push_back(std::move(rule));
+}
+
+void SyntaxDefinition::addRegion(QString const &begin, QString const &end, Style style)
+{
+	Rule rule{ QRegularExpression(begin), QRegularExpression(end), style };
+	rule.pattern.optimize();
+	rule.end.optimize();
+	rules.push_back(std::move(rule));
+}
+
+int SyntaxDefinition::tokenize(QString const &text, int state, std::vector<Span> &spans) const
+{
+	qsizetype pos = 0;
+	if (state > 0 && size_t(state) <= rules.size())
+	{
+		// A region left open by the line before goes on up to its end, or over all of this line.
+		Rule const &open = rules[state - 1];
+		const QRegularExpressionMatch end = open.end.match(text);
+		pos = end.hasMatch() ? end.capturedEnd() : text.size();
+		if (pos > 0)
+		{
+			spans.push_back({ 0, int(pos), open.style });
+		}
+
+		if (!end.hasMatch())
+		{
+			return state;
+		}
+	}
+
+	// The next match of every rule, only looked for again once the text before it has been passed.
+	std::vector<QRegularExpressionMatch> found(rules.size());
+	std::vector<bool> exhausted(rules.size(), false);
+	while (pos < text.size())
+	{
+		size_t best = rules.size();
+		for (size_t i = 0; i < rules.size(); ++i)
+		{
+			if (!exhausted[i] && (!found[i].hasMatch() || found[i].capturedStart() < pos))
+			{
+				found[i] = rules[i].pattern.match(text, pos);
+				exhausted[i] = !found[i].hasMatch();
+			}
+
+			if (!exhausted[i] && (best == rules.size() || found[i].capturedStart() < found[best].capturedStart()))
+			{
+				best = i;
+			}
+		}
+
+		if (best == rules.size())
+		{
+			break;
+		}
+
+		const qsizetype start = found[best].capturedStart();
+		qsizetype stop = found[best].capturedEnd();
+		if (stop == start)
+		{
+			// Nothing to color, but the rule must not match in the same place again.
+			pos = start + 1;
+			continue;
+		}
+
+		Rule const &rule = rules[best];
+		if (!rule.end.pattern().isEmpty())
+		{
+			const QRegularExpressionMatch end = rule.end.match(text, stop);
+			if (!end.hasMatch())
+			{
+				spans.push_back({ int(start), int(text.size() - start), rule.style });
+				return int(best) + 1;
+			}
+
+			stop = end.capturedEnd();
+		}
+
+		spans.push_back({ int(start), int(stop - start), rule.style });
+		pos = stop;
+	}
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** syntaxdefinition.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <vector>
+
+// Rules for coloring one kind of text, matched a line at a time.  Whichever rule matches first wins, the earlier one
+// on a tie.  A rule with an end pattern opens a region that may go on over the following lines, and the state a line
+// ends in says which region is still open, 0 being none.
+class SyntaxDefinition
+{
+public:
+	enum Style
+	{
+		Comment,
+		Keyword,
+		String,
+		Number,
+		Key,
+		Section,
+		Time,
+		Error,
+		Warning,
+		Info,
+		StyleCount
+	};
+
+	struct Span
+	{
+		int start;
+		int length;
+		Style style;
+	};
+
+	SyntaxDefinition(QString const &name, QStringList const &suffixes);
+
+	// The definitions that come with the editor.
+	static std::vector<std::shared_ptr<SyntaxDefinition const>> const &builtIn();
+	// Definition for the file by its suffix, or null for plain text.
+	static std::shared_ptr<SyntaxDefinition const> forFile(QString const &fileName);
+
+	QString name() const;
+	QStringList suffixes() const;
+	void addRule(QString const &pattern, Style style,
+	             QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption);
+	void addRegion(QString const &begin, QString const &end, Style style);
+
+	// Adds the spans of one line to spans, returning the state at its end.
+	int tokenize(QString const &text, int state, std::vector<Span> &spans) const;
+
+private:
+	struct Rule
+	{
+		QRegularExpression pattern;
+		// Empty for a rule that does not open a region.
+		QRegularExpression end;
+		Style style;
+	};
+
+	QString title;
+	QStringList fileSuffixes;
+	std::vector<Rule> rules;
+};
@@ -0,0 +1,312 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** syntaxhighlighter.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "syntaxhighlighter.hpp"
+
+#include <QGuiApplication>
+#include <QPalette>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "syntaxdefinition.hpp"
+
+// Milliseconds of coloring done in the background before the event loop gets a turn.
+constexpr int HIGHLIGHT_SLICE = 8;
+// An edit touching more blocks than this, such as a paste or a batch of a file being loaded, is left to the background.
+constexpr int EDIT_BLOCKS = 32;
+
+// Text colors in the order of SyntaxDefinition::Style, for light backgrounds and for dark ones.
+constexpr std::array<QRgb, SyntaxDefinition::StyleCount> LIGHT_COLORS = {
+	0x008000, 0x0000c0, 0xa31515, 0x098658, 0x00458b, 0x800080, 0x267f99, 0xcd0000, 0xb06e00, 0x0000c0
+};
+constexpr std::array<QRgb, SyntaxDefinition::StyleCount> DARK_COLORS = {
+	0x6a9955, 0x569cd6, 0xce9178, 0xb5cea8, 0x9cdcfe, 0xc586c0, 0x4ec9b0, 0xf44747, 0xdcdc60, 0x569cd6
+};
+
+namespace
+{
+using StyleFormats = std::array<QTextCharFormat, SyntaxDefinition::StyleCount>;
+
+// Only the color of the text changes, never its width, so coloring a block can not change how it wraps.
+StyleFormats styleFormats()
+{
+	const bool dark = QGuiApplication::palette().color(QPalette::Base).lightness() < 128;
+	StyleFormats formats;
+	for (size_t i = 0; i < formats.size(); ++i)
+	{
+		formats[i].setForeground(QColor(dark ? DARK_COLORS[i] : LIGHT_COLORS[i]));
+	}
+
+	return formats;
+}
+}
+
+struct SyntaxHighlighter::Impl
+{
+	Impl(QTextDocument *document) :
+	    document(document),
+	    blockCount(document->blockCount())
+	{
+		timer.setSingleShot(true);
+		timer.setInterval(0);
+	}
+
+	int stateBefore(QTextBlock const &block) const
+	{
+		const QTextBlock previous = block.previous();
+		return previous.isValid() ? std::max(0, previous.userState()) : 0;
+	}
+
+	// Colors one block starting in the given state and returns the state it ends in.  A block without a definition is
+	// uncolored and forgets its state.
+	int highlight(QTextBlock block, int state, int number, bool keepLayout = false)
+	{
+		int next = -1;
+		QList<QTextLayout::FormatRange> ranges;
+		if (definition)
+		{
+			spans.clear();
+			next = definition->tokenize(block.text(), state, spans);
+			ranges.reserve(qsizetype(spans.size()));
+			for (SyntaxDefinition::Span const &span : spans)
+			{
+				ranges.append({ span.start, span.length, formats[span.style] });
+			}
+		}
+
+		block.setUserState(next);
+		QTextLayout *layout = block.layout();
+		if (ranges.isEmpty() && layout->formats().isEmpty())
+		{
+			return next;
+		}
+
+		layout->setFormats(ranges);
+		colored = true;
+		document->markContentsDirty(block.position(), block.length());
+		// Telling the document lays the block out, which out of view would only hold on to memory.
+		if (!keepLayout && (number < shownFirst || number > shownLast))
+		{
+			block.clearLayout();
+		}
+
+		return next;
+	}
+
+	QTextDocument *document;
+	std::shared_ptr<SyntaxDefinition const> definition;
+	StyleFormats formats;
+	std::vector<SyntaxDefinition::Span> spans;
+	QTimer timer;
+	int blockCount;
+	// First block the background has not colored yet, every block before it is right unless an edit is pending.
+	int frontier = 0;
+	// First block an edit left to the background, and the last one that has to be colored again before the state can
+	// be trusted to be unchanged.
+	int pending = -1;
+	int pendingUntil = -1;
+	int shownFirst = 0;
+	int shownLast = -1;
+	bool colored = false;
+};
+
+SyntaxHighlighter::SyntaxHighlighter(QTextDocument *document, QObject *parent) :
+    QObject(parent),
+    im(std::make_unique<SyntaxHighlighter::Impl>(document))
+{
+	QObject::connect(document, SIGNAL(contentsChange(int,int,int)), this, SLOT(documentChanged(int,int,int)));
+	QObject::connect(&im->timer, SIGNAL(timeout()), this, SLOT(highlightSlice()));
+}
+
+SyntaxHighlighter::~SyntaxHighlighter()
+{
+	// No implementation.
+}
+
+std::shared_ptr<SyntaxDefinition const> SyntaxHighlighter::definition() const
+{
+	return im->definition;
+}
+
+void SyntaxHighlighter::setDefinition(std::shared_ptr<SyntaxDefinition const> definition)
+{
+	if (definition == im->definition)
+	{
+		return;
+	}
+
+	im->definition = std::move(definition);
+	im->formats = styleFormats();
+	im->blockCount = im->document->blockCount();
+	im->frontier = 0;
+	im->pending = -1;
+	im->pendingUntil = -1;
+	if (!im->definition && !im->colored)
+	{
+		im->timer.stop();
+		return;
+	}
+
+	// The blocks in view still have the states of the old definition, so they are redone whatever their state says.
+	QTextBlock block = im->document->findBlockByNumber(im->shownFirst);
+	for (int number = im->shownFirst; block.isValid() && number <= im->shownLast; block = block.next(), ++number)
+	{
+		im->highlight(block, im->stateBefore(block), number);
+	}
+
+	im->timer.start();
+}
+
+void SyntaxHighlighter::showBlocks(int first, int last)
+{
+	im->shownFirst = first;
+	im->shownLast = last;
+	if (!im->definition)
+	{
+		return;
+	}
+
+	// Blocks before the frontier are right already.  Past it the state a block starts in is a guess, which the
+	// background puts right once it gets there.
+	const int from = std::max(first, im->frontier);
+	QTextBlock block = im->document->findBlockByNumber(from);
+	for (int number = from; block.isValid() && number <= last; block = block.next(), ++number)
+	{
+		if (block.userState() < 0)
+		{
+			im->highlight(block, im->stateBefore(block), number);
+		}
+	}
+}
+
+void SyntaxHighlighter::documentChanged(int position, int charsRemoved, int charsAdded)
+{
+	Q_UNUSED(charsRemoved)
+	QTextDocument *doc = im->document;
+	const int count = doc->blockCount();
+	const int delta = count - im->blockCount;
+	im->blockCount = count;
+	if (!im->definition)
+	{
+		return;
+	}
+
+	QTextBlock first = doc->findBlock(position);
+	QTextBlock last = doc->findBlock(position + charsAdded);
+	first = first.isValid() ? first : doc->lastBlock();
+	last = last.isValid() ? last : doc->lastBlock();
+	const int from = first.blockNumber();
+	const int to = last.blockNumber();
+
+	// Whatever came after the edit moved along with the blocks it added or removed.
+	for (int *number : { &im->frontier, &im->pending, &im->pendingUntil })
+	{
+		if (*number > from)
+		{
+			*number = std::max(from, *number + delta);
+		}
+	}
+
+	if (to - from >= EDIT_BLOCKS)
+	{
+		im->frontier = std::min(im->frontier, from);
+		im->timer.start();
+		return;
+	}
+
+	// Typing only ever touches a block or two, which are done right away.  The document lays them out itself once
+	// the edit is over.
+	int state = im->stateBefore(first);
+	int old = -1;
+	int number = from;
+	for (QTextBlock block = first; block.isValid(); block = block.next())
+	{
+		old = block.userState();
+		state = im->highlight(block, state, number++, true);
+		if (block == last)
+		{
+			break;
+		}
+	}
+
+	if (state != old && to + 1 < im->frontier)
+	{
+		im->pending = im->pending < 0 ? to + 1 : std::min(im->pending, to + 1);
+		im->pendingUntil = std::max(im->pendingUntil, to + 1);
+		im->timer.start();
+	}
+}
+
+void SyntaxHighlighter::highlightSlice()
+{
+	QElapsedTimer clock;
+	clock.start();
+	QTextDocument *doc = im->document;
+	if (im->pending >= 0)
+	{
+		// An edit changed the state its last block ended in, so the blocks after it are colored again until theirs
+		// comes out the same as before.
+		int number = im->pending;
+		QTextBlock block = doc->findBlockByNumber(number);
+		int state = im->stateBefore(block);
+		bool settled = false;
+		while (!settled && block.isValid() && number < im->frontier && clock.elapsed() < HIGHLIGHT_SLICE)
+		{
+			const int old = block.userState();
+			state = im->highlight(block, state, number);
+			settled = state == old && number >= im->pendingUntil;
+			block = block.next();
+			++number;
+		}
+
+		if (settled || !block.isValid() || number >= im->frontier)
+		{
+			im->pending = -1;
+			im->pendingUntil = -1;
+		}
+		else
+		{
+			im->pending = number;
+		}
+	}
+
+	QTextBlock block = doc->findBlockByNumber(im->frontier);
+	int state = im->stateBefore(block);
+	while (block.isValid() && clock.elapsed() < HIGHLIGHT_SLICE)
+	{
+		state = im->highlight(block, state, im->frontier);
+		block = block.next();
+		++im->frontier;
+	}
+
+	if (im->pending >= 0 || block.isValid())
+	{
+		im->timer.start();
+	}
+	else if (!im->definition)
+	{
+		im->colored = false;
+	}
+}
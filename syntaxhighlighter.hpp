@@ -0,0 +1,53 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** syntaxhighlighter.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QObject>
+
+#include <memory>
+
+class QTextDocument;
+class SyntaxDefinition;
+
+// Colors a document by a SyntaxDefinition without ever going over all of it at once.  The blocks in view are colored as
+// soon as they are shown, the rest in slices while the event loop is idle.  Every block keeps the state its line ended
+// in, so an edit only goes on into the blocks after it for as long as their state comes out different than before.
+class SyntaxHighlighter : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit SyntaxHighlighter(QTextDocument *document, QObject *parent = nullptr);
+	~SyntaxHighlighter();
+
+	std::shared_ptr<SyntaxDefinition const> definition() const;
+	// Starts over with another definition, or takes the colors off again for none.
+	void setDefinition(std::shared_ptr<SyntaxDefinition const> definition);
+	// Colors the blocks from first to last now if the background has not been there yet.  Blocks colored outside of
+	// the range last shown drop their layout again.
+	void showBlocks(int first, int last);
+
+private slots:
+	void documentChanged(int position, int charsRemoved, int charsAdded);
+	void highlightSlice();
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> im;
+};
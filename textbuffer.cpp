@@ -0,0 +1,592 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** textbuffer.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "textbuffer.hpp"
+
+#include <QIODevice>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <cstring>
+
+#include "lineindex.hpp"
+#include "mappedfile.hpp"
+
+// Inserted text is packed into pages of this size, anything larger gets a page of its own.
+constexpr qint64 PAGE_SIZE = 64 << 10;
+
+TextBuffer::TextBuffer() :
+    pageFill(0),
+    added(0),
+    root(-1),
+    used(0),
+    edits(0)
+{
+	// No implementation.
+}
+
+TextBuffer::TextBuffer(std::shared_ptr<MappedFile> original) :
+    TextBuffer()
+{
+	source = std::move(original);
+	if (source && source->size() > 0)
+	{
+		root = newPiece(-1, 0, source->size(), QRandomGenerator::global()->generate());
+	}
+}
+
+TextBuffer::TextBuffer(TextBuffer const &other) :
+    source(other.source),
+    lineIndex(other.lineIndex),
+    pages(other.pages),
+    pageFill(other.pageFill),
+    added(other.added),
+    pieces(other.pieces),
+    freePieces(other.freePieces),
+    root(other.root),
+    used(other.used),
+    edits(other.edits)
+{
+	// The last page is still being filled by the buffer this was copied from, so never write into it from here.
+	if (!pages.empty())
+	{
+		pageFill = pages.back().capacity;
+	}
+}
+
+TextBuffer &TextBuffer::operator=(TextBuffer const &other)
+{
+	if (this != &other)
+	{
+		TextBuffer copy(other);
+		std::swap(source, copy.source);
+		std::swap(lineIndex, copy.lineIndex);
+		std::swap(pages, copy.pages);
+		std::swap(pageFill, copy.pageFill);
+		std::swap(added, copy.added);
+		std::swap(pieces, copy.pieces);
+		std::swap(freePieces, copy.freePieces);
+		std::swap(root, copy.root);
+		std::swap(used, copy.used);
+		std::swap(edits, copy.edits);
+	}
+
+	return *this;
+}
+
+TextBuffer::~TextBuffer()
+{
+	// No implementation.
+}
+
+std::shared_ptr<MappedFile> TextBuffer::original() const
+{
+	return source;
+}
+
+qint64 TextBuffer::size() const
+{
+	return total(root);
+}
+
+qint64 TextBuffer::addedBytes() const
+{
+	return added;
+}
+
+int TextBuffer::pieceCount() const
+{
+	return used;
+}
+
+quint64 TextBuffer::revision() const
+{
+	return edits;
+}
+
+QByteArray TextBuffer::read(qint64 offset, qint64 length) const
+{
+	offset = std::clamp<qint64>(offset, 0, size());
+	length = std::clamp<qint64>(length, 0, size() - offset);
+	QByteArray result(length, Qt::Uninitialized);
+	char *out = result.data();
+	forEachChunk(offset, offset + length, [&out](const char *data, qint64 chunk) {
+		std::memcpy(out, data, size_t(chunk));
+		out += chunk;
+		return true;
+	});
+
+	return result;
+}
+
+void TextBuffer::insert(qint64 offset, QByteArray const &bytes)
+{
+	const qint64 length = bytes.size();
+	if (length == 0)
+	{
+		return;
+	}
+
+	int left, right;
+	split(root, std::clamp<qint64>(offset, 0, size()), left, right);
+
+	int last = left;
+	while (last >= 0 && pieces[last].right >= 0)
+	{
+		last = pieces[last].right;
+	}
+
+	// Typing appends to the piece that was just inserted, so grow it in place rather than adding a piece per key.
+	if (last >= 0 && pieces[last].page == int(pages.size()) - 1 && pieces[last].start + pieces[last].length == pageFill
+	    && pageFill + length <= pages.back().capacity)
+	{
+		std::memcpy(pages.back().data.get() + pageFill, bytes.constData(), size_t(length));
+		pageFill += length;
+		Piece &piece = pieces[last];
+		const qint64 grown = piece.length;
+		piece.length += length;
+		// Only the bytes added are counted, and a \r the piece ended in is now followed by the first of them.
+		qint64 breaks = countBreaks(piece, grown, piece.length);
+		if (pieceData(piece)[grown - 1] == '\r')
+		{
+			breaks += (piece.lfAfter ? 1 : 0) - (bytes[0] == '\n' ? 1 : 0);
+		}
+
+		piece.lfAfter = false;
+		piece.breaks += breaks;
+		for (int node = left; node >= 0; node = pieces[node].right)
+		{
+			pieces[node].total += length;
+			pieces[node].totalBreaks += breaks;
+		}
+	}
+	else
+	{
+		if (pages.empty() || pageFill + length > pages.back().capacity)
+		{
+			const qint64 capacity = std::max(PAGE_SIZE, length);
+			pages.push_back({ std::shared_ptr<char[]>(new char[size_t(capacity)]), capacity });
+			pageFill = 0;
+		}
+
+		std::memcpy(pages.back().data.get() + pageFill, bytes.constData(), size_t(length));
+		int piece = newPiece(int(pages.size()) - 1, pageFill, length, QRandomGenerator::global()->generate());
+		pageFill += length;
+		left = join(left, piece);
+	}
+
+	added += length;
+	++edits;
+	root = join(left, right);
+}
+
+void TextBuffer::remove(qint64 offset, qint64 length)
+{
+	offset = std::clamp<qint64>(offset, 0, size());
+	length = std::clamp<qint64>(length, 0, size() - offset);
+	if (length == 0)
+	{
+		return;
+	}
+
+	int left, rest, middle, right;
+	split(root, offset, left, rest);
+	split(rest, length, middle, right);
+	release(middle);
+	++edits;
+	root = join(left, right);
+}
+
+std::vector<TextBuffer::Extent> TextBuffer::extents(qint64 offset, qint64 length) const
+{
+	offset = std::clamp<qint64>(offset, 0, size());
+	length = std::clamp<qint64>(length, 0, size() - offset);
+	std::vector<Extent> runs;
+	gather(root, 0, offset, offset + length, runs);
+	return runs;
+}
+
+void TextBuffer::insert(qint64 offset, std::vector<Extent> const &runs)
+{
+	if (runs.empty())
+	{
+		return;
+	}
+
+	int left, right;
+	split(root, std::clamp<qint64>(offset, 0, size()), left, right);
+	for (Extent const &run : runs)
+	{
+		if (run.length > 0 && run.page < int(pages.size()) && (run.page >= 0 || source))
+		{
+			left = join(left, newPiece(run.page, run.start, run.length, QRandomGenerator::global()->generate()));
+		}
+	}
+
+	++edits;
+	root = join(left, right);
+}
+
+bool TextBuffer::forEachChunk(qint64 from, qint64 to, ChunkFunc const &func) const
+{
+	return visit(root, 0, std::max<qint64>(from, 0), std::min(to, size()), func);
+}
+
+bool TextBuffer::writeTo(QIODevice &device) const
+{
+	return forEachChunk(0, size(), [&device](const char *data, qint64 length) {
+		return device.write(data, length) == length;
+	});
+}
+
+bool TextBuffer::hasLineIndex() const
+{
+	return lineIndex || !source || source->size() == 0;
+}
+
+void TextBuffer::setLineIndex(std::shared_ptr<LineIndex const> index)
+{
+	lineIndex = std::move(index);
+	refreshBreaks(root);
+}
+
+qint64 TextBuffer::lineBreaks() const
+{
+	return totalBreaks(root);
+}
+
+qint64 TextBuffer::lineStart(qint64 line) const
+{
+	line = std::min(line, lineBreaks());
+	qint64 base = 0;
+	int node = root;
+	while (line > 0 && node >= 0)
+	{
+		Piece const &piece = pieces[node];
+		const qint64 leftBreaks = totalBreaks(piece.left);
+		if (line <= leftBreaks)
+		{
+			node = piece.left;
+		}
+		else if (line <= leftBreaks + piece.breaks)
+		{
+			return base + total(piece.left) + breakEnd(piece, line - leftBreaks);
+		}
+		else
+		{
+			line -= leftBreaks + piece.breaks;
+			base += total(piece.left) + piece.length;
+			node = piece.right;
+		}
+	}
+
+	return base;
+}
+
+qint64 TextBuffer::lineAt(qint64 offset) const
+{
+	qint64 line = 0;
+	int node = root;
+	while (node >= 0)
+	{
+		Piece const &piece = pieces[node];
+		const qint64 leftLength = total(piece.left);
+		if (offset < leftLength)
+		{
+			node = piece.left;
+			continue;
+		}
+
+		line += totalBreaks(piece.left);
+		offset -= leftLength;
+		if (offset < piece.length)
+		{
+			return line + countBreaks(piece, 0, offset);
+		}
+
+		line += piece.breaks;
+		offset -= piece.length;
+		node = piece.right;
+	}
+
+	return line;
+}
+
+qint64 TextBuffer::total(int node) const
+{
+	return node < 0 ? 0 : pieces[node].total;
+}
+
+qint64 TextBuffer::totalBreaks(int node) const
+{
+	return node < 0 ? 0 : pieces[node].totalBreaks;
+}
+
+qint64 TextBuffer::countBreaks(Piece const &piece, qint64 from, qint64 to) const
+{
+	if (piece.page < 0)
+	{
+		return lineIndex ? lineIndex->breaks(piece.start + from, piece.start + to) : 0;
+	}
+
+	const char *data = pieceData(piece);
+	return LineIndex::countBreaks(data + from, data + to, data + piece.length);
+}
+
+qint64 TextBuffer::breaksFrom(Piece const &piece, qint64 from) const
+{
+	const qint64 count = countBreaks(piece, from, piece.length);
+	if ((piece.page < 0 && !lineIndex) || pieceData(piece)[piece.length - 1] != '\r')
+	{
+		return count;
+	}
+
+	// A \r at the end was counted as a break of its own, unless it is in the file and the file goes on with a \n.
+	const qint64 end = piece.start + piece.length;
+	const bool counted = piece.page >= 0 || end == source->size() || source->data()[end] != '\n';
+	return count - (counted ? 1 : 0) + (piece.lfAfter ? 0 : 1);
+}
+
+qint64 TextBuffer::breakEnd(Piece const &piece, qint64 count) const
+{
+	if (piece.page < 0)
+	{
+		// The file may go on with a \n where the buffer does not, which makes a \r at the end a break of its own.
+		return std::min(lineIndex->lineStart(lineIndex->breaks(0, piece.start) + count) - piece.start, piece.length);
+	}
+
+	const char *data = pieceData(piece);
+	return LineIndex::findBreak(data, data + piece.length, data + piece.length, count);
+}
+
+void TextBuffer::refreshBreaks(int node)
+{
+	if (node >= 0)
+	{
+		refreshBreaks(pieces[node].left);
+		refreshBreaks(pieces[node].right);
+		pieces[node].breaks = breaksFrom(pieces[node], 0);
+		update(node);
+	}
+}
+
+void TextBuffer::update(int node)
+{
+	Piece &piece = pieces[node];
+	piece.total = piece.length + total(piece.left) + total(piece.right);
+	piece.totalBreaks = piece.breaks + totalBreaks(piece.left) + totalBreaks(piece.right);
+}
+
+const char *TextBuffer::pieceData(Piece const &piece) const
+{
+	return piece.page < 0 ? source->data() + piece.start : pages[piece.page].data.get() + piece.start;
+}
+
+int TextBuffer::newPiece(int page, qint64 start, qint64 length, quint32 priority, qint64 breaks)
+{
+	Piece piece = { -1, -1, priority, page, start, length, length, 0, 0, false };
+	piece.breaks = piece.totalBreaks = breaks < 0 ? breaksFrom(piece, 0) : breaks;
+	++used;
+	if (!freePieces.empty())
+	{
+		int node = freePieces.back();
+		freePieces.pop_back();
+		pieces[node] = piece;
+		return node;
+	}
+
+	pieces.push_back(piece);
+	return int(pieces.size()) - 1;
+}
+
+void TextBuffer::release(int node)
+{
+	if (node >= 0)
+	{
+		release(pieces[node].left);
+		release(pieces[node].right);
+		freePieces.push_back(node);
+		--used;
+	}
+}
+
+void TextBuffer::split(int node, qint64 offset, int &left, int &right)
+{
+	if (node < 0)
+	{
+		left = right = -1;
+		return;
+	}
+
+	// Nodes may be added further down, so nothing here may hold a reference into pieces across the recursion.
+	const qint64 leftTotal = total(pieces[node].left);
+	int first, second;
+	if (offset <= leftTotal)
+	{
+		split(pieces[node].left, offset, first, second);
+		pieces[node].left = second;
+		update(node);
+		left = first;
+		right = node;
+	}
+	else if (offset >= leftTotal + pieces[node].length)
+	{
+		split(pieces[node].right, offset - leftTotal - pieces[node].length, first, second);
+		pieces[node].right = first;
+		update(node);
+		left = node;
+		right = second;
+	}
+	else
+	{
+		// The cut falls inside this piece.  The tail inherits the priority, which keeps both halves valid heaps, and
+		// the byte after the piece.  Only the shorter half has its breaks counted, the other has the rest.
+		const qint64 inner = offset - leftTotal;
+		const Piece piece = pieces[node];
+		Piece tailPiece = piece;
+		tailPiece.start += inner;
+		tailPiece.length -= inner;
+		const qint64 tailBreaks = inner < tailPiece.length ? piece.breaks - countBreaks(piece, 0, inner)
+		                                                   : breaksFrom(tailPiece, 0);
+		int tail = newPiece(piece.page, tailPiece.start, tailPiece.length, piece.priority, tailBreaks);
+		pieces[tail].lfAfter = piece.lfAfter;
+		pieces[tail].right = pieces[node].right;
+		pieces[node].right = -1;
+		pieces[node].length = inner;
+		pieces[node].breaks = piece.breaks - tailBreaks;
+		pieces[node].lfAfter = *pieceData(pieces[tail]) == '\n';
+		update(tail);
+		update(node);
+		left = node;
+		right = tail;
+	}
+}
+
+int TextBuffer::join(int left, int right)
+{
+	if (left >= 0)
+	{
+		int first = right;
+		while (first >= 0 && pieces[first].left >= 0)
+		{
+			first = pieces[first].left;
+		}
+
+		settle(left, first >= 0 && *pieceData(pieces[first]) == '\n');
+	}
+
+	return merge(left, right);
+}
+
+void TextBuffer::settle(int node, bool lfAfter)
+{
+	Piece &piece = pieces[node];
+	if (piece.right >= 0)
+	{
+		settle(piece.right, lfAfter);
+		update(node);
+		return;
+	}
+
+	if (piece.lfAfter == lfAfter)
+	{
+		return;
+	}
+
+	piece.lfAfter = lfAfter;
+	if (pieceData(piece)[piece.length - 1] == '\r' && (piece.page >= 0 || lineIndex))
+	{
+		piece.breaks += lfAfter ? -1 : 1;
+		update(node);
+	}
+}
+
+int TextBuffer::merge(int left, int right)
+{
+	if (left < 0 || right < 0)
+	{
+		return left < 0 ? right : left;
+	}
+
+	if (pieces[left].priority >= pieces[right].priority)
+	{
+		int merged = merge(pieces[left].right, right);
+		pieces[left].right = merged;
+		update(left);
+		return left;
+	}
+
+	int merged = merge(left, pieces[right].left);
+	pieces[right].left = merged;
+	update(right);
+	return right;
+}
+
+bool TextBuffer::visit(int node, qint64 base, qint64 from, qint64 to, ChunkFunc const &func) const
+{
+	if (node < 0 || from >= to)
+	{
+		return true;
+	}
+
+	Piece const &piece = pieces[node];
+	const qint64 pieceStart = base + total(piece.left);
+	const qint64 pieceEnd = pieceStart + piece.length;
+	if (from < pieceStart && !visit(piece.left, base, from, to, func))
+	{
+		return false;
+	}
+
+	if (from < pieceEnd && to > pieceStart)
+	{
+		const qint64 first = std::max(from, pieceStart);
+		if (!func(pieceData(piece) + (first - pieceStart), std::min(to, pieceEnd) - first))
+		{
+			return false;
+		}
+	}
+
+	return to <= pieceEnd || visit(piece.right, pieceEnd, from, to, func);
+}
+
+void TextBuffer::gather(int node, qint64 base, qint64 from, qint64 to, std::vector<Extent> &runs) const
+{
+	if (node < 0 || from >= to)
+	{
+		return;
+	}
+
+	Piece const &piece = pieces[node];
+	const qint64 pieceStart = base + total(piece.left);
+	const qint64 pieceEnd = pieceStart + piece.length;
+	if (from < pieceStart)
+	{
+		gather(piece.left, base, from, to, runs);
+	}
+
+	if (from < pieceEnd && to > pieceStart)
+	{
+		const qint64 first = std::max(from, pieceStart);
+		runs.push_back({ piece.page, piece.start + (first - pieceStart), std::min(to, pieceEnd) - first });
+	}
+
+	if (to > pieceEnd)
+	{
+		gather(piece.right, pieceEnd, from, to, runs);
+	}
+}
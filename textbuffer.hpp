@@ -0,0 +1,144 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** textbuffer.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class LineIndex;
+class MappedFile;
+class QIODevice;
+
+// A piece table over a read-only mapped file.  Inserted text is appended to private pages that are never rewritten, and
+// the document is described by a balanced tree of pieces referencing either the file or those pages, so an edit costs
+// O(log n) in the number of pieces and memory only grows with the amount of text inserted.
+//
+// Each piece also knows how many line breaks it holds, which makes finding a line or the line of an offset O(log n) as
+// well.  Breaks in the original file are only known once its LineIndex is set, built in the background since that
+// means reading all of the file.
+//
+// Copies share the file and the pages, so a copy is a cheap snapshot that may be read from another thread while the
+// original keeps being edited.
+class TextBuffer
+{
+public:
+	// Called with consecutive runs of bytes, stops the iteration when it returns false.
+	using ChunkFunc = std::function<bool(const char *data, qint64 length)>;
+
+	// A run of bytes the buffer holds, in its file or in one of its pages.  Neither is ever written over, so text taken
+	// out of the buffer can be put back by its runs for as long as the buffer lives, without ever being copied.
+	struct Extent
+	{
+		// Index into the pages, or -1 for the original file.
+		int page;
+		qint64 start;
+		qint64 length;
+	};
+
+	TextBuffer();
+	explicit TextBuffer(std::shared_ptr<MappedFile> original);
+	TextBuffer(TextBuffer const &other);
+	TextBuffer &operator=(TextBuffer const &other);
+	~TextBuffer();
+
+	std::shared_ptr<MappedFile> original() const;
+	qint64 size() const;
+	qint64 addedBytes() const;
+	int pieceCount() const;
+	// Changes with every edit, so a snapshot can tell whether the buffer moved on since it was taken.
+	quint64 revision() const;
+
+	QByteArray read(qint64 offset, qint64 length) const;
+	void insert(qint64 offset, QByteArray const &bytes);
+	void remove(qint64 offset, qint64 length);
+	// The runs holding the given range, and putting runs taken from this same buffer back in.
+	std::vector<Extent> extents(qint64 offset, qint64 length) const;
+	void insert(qint64 offset, std::vector<Extent> const &runs);
+
+	bool forEachChunk(qint64 from, qint64 to, ChunkFunc const &func) const;
+	bool writeTo(QIODevice &device) const;
+
+	bool hasLineIndex() const;
+	void setLineIndex(std::shared_ptr<LineIndex const> index);
+	// The buffer holds one more line than it has breaks.
+	qint64 lineBreaks() const;
+	// Offset where the given zero based line starts, clamped to the last line.
+	qint64 lineStart(qint64 line) const;
+	// Zero based line holding the byte at offset.
+	qint64 lineAt(qint64 offset) const;
+
+private:
+	struct Page
+	{
+		std::shared_ptr<char[]> data;
+		qint64 capacity;
+	};
+
+	struct Piece
+	{
+		int left;
+		int right;
+		quint32 priority;
+		// Index into pages, or -1 for the original file.
+		int page;
+		qint64 start;
+		qint64 length;
+		// Length of this piece and everything below it.
+		qint64 total;
+		// Breaks sit on their last byte, so a \r the piece ends in is only one if the byte after it is not a \n.
+		qint64 breaks;
+		qint64 totalBreaks;
+		bool lfAfter;
+	};
+
+	qint64 total(int node) const;
+	qint64 totalBreaks(int node) const;
+	// Breaks within [from, to) of the piece, and the offset in the piece just past its count'th break.
+	qint64 countBreaks(Piece const &piece, qint64 from, qint64 to) const;
+	// Breaks from the given offset of the piece to its end, with a \r at the end settled by what comes after it.
+	qint64 breaksFrom(Piece const &piece, qint64 from) const;
+	qint64 breakEnd(Piece const &piece, qint64 count) const;
+	void refreshBreaks(int node);
+	void update(int node);
+	const char *pieceData(Piece const &piece) const;
+	// Counts the breaks of the new piece unless they are given.  It is taken to be followed by anything but a \n.
+	int newPiece(int page, qint64 start, qint64 length, quint32 priority, qint64 breaks = -1);
+	void release(int node);
+	void split(int node, qint64 offset, int &left, int &right);
+	int merge(int left, int right);
+	// Merges two trees once the last piece of the left one knows whether the right one starts with a \n.
+	int join(int left, int right);
+	void settle(int node, bool lfAfter);
+	bool visit(int node, qint64 base, qint64 from, qint64 to, ChunkFunc const &func) const;
+	void gather(int node, qint64 base, qint64 from, qint64 to, std::vector<Extent> &runs) const;
+
+	std::shared_ptr<MappedFile> source;
+	std::shared_ptr<LineIndex const> lineIndex;
+	std::vector<Page> pages;
+	qint64 pageFill;
+	qint64 added;
+	std::vector<Piece> pieces;
+	std::vector<int> freePieces;
+	int root;
+	int used;
+	quint64 edits;
+};
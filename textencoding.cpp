@@ -0,0 +1,240 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** textencoding.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "textencoding.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTENCODING_SSE2
+#endif
+
+// Bytes looked at to tell UTF-16 apart from the rest.
+constexpr qint64 DETECT_SAMPLE = 64 << 10;
+
+namespace
+{
+// Length of the valid sequence starting at p, 0 when it is cut off by end but fine so far, or -1 when it is invalid.
+int sequenceLength(const uchar *p, const uchar *end)
+{
+	const uchar lead = *p;
+	int length;
+	uchar low = 0x80, high = 0xBF;
+	if (lead < 0x80)
+	{
+		return 1;
+	}
+	else if (lead >= 0xC2 && lead <= 0xDF)
+	{
+		length = 2;
+	}
+	else if (lead >= 0xE0 && lead <= 0xEF)
+	{
+		// No overlong forms, and no surrogates.
+		length = 3;
+		low = lead == 0xE0 ? 0xA0 : 0x80;
+		high = lead == 0xED ? 0x9F : 0xBF;
+	}
+	else if (lead >= 0xF0 && lead <= 0xF4)
+	{
+		// No overlong forms, and nothing past U+10FFFF.
+		length = 4;
+		low = lead == 0xF0 ? 0x90 : 0x80;
+		high = lead == 0xF4 ? 0x8F : 0xBF;
+	}
+	else
+	{
+		return -1;
+	}
+
+	for (int i = 1; i < length; ++i)
+	{
+		if (p + i == end)
+		{
+			return 0;
+		}
+
+		if (p[i] < low || p[i] > high)
+		{
+			return -1;
+		}
+
+		low = 0x80;
+		high = 0xBF;
+	}
+
+	return length;
+}
+}
+
+TextEncoding::TextEncoding(QStringConverter::Encoding encoding, bool bom) :
+    enc(encoding),
+    bom(bom)
+{
+	// No implementation.
+}
+
+TextEncoding TextEncoding::detect(const char *data, qint64 length, bool atEnd)
+{
+	const uchar *bytes = reinterpret_cast<const uchar *>(data);
+	if (length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+	{
+		return TextEncoding(QStringConverter::Utf8, true);
+	}
+	else if (length >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE)
+	{
+		return TextEncoding(QStringConverter::Utf16LE, true);
+	}
+	else if (length >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF)
+	{
+		return TextEncoding(QStringConverter::Utf16BE, true);
+	}
+
+	// Text that is mostly ASCII puts a zero in the high byte of nearly every unit, which no other encoding does.
+	const qint64 sample = std::min(length, DETECT_SAMPLE);
+	const qint64 units = sample / 2;
+	qint64 evenZeros = 0, oddZeros = 0;
+	for (qint64 i = 0; i + 1 < sample; i += 2)
+	{
+		evenZeros += bytes[i] == 0;
+		oddZeros += bytes[i + 1] == 0;
+	}
+
+	if (units > 0 && oddZeros * 5 >= units * 2 && evenZeros * 20 <= units)
+	{
+		return TextEncoding(QStringConverter::Utf16LE);
+	}
+	else if (units > 0 && evenZeros * 5 >= units * 2 && oddZeros * 20 <= units)
+	{
+		return TextEncoding(QStringConverter::Utf16BE);
+	}
+
+	bool truncated = false;
+	const qint64 valid = validUtf8(data, sample, truncated);
+	if (valid == sample || (truncated && (sample < length || !atEnd)))
+	{
+		return TextEncoding(QStringConverter::Utf8);
+	}
+
+	return TextEncoding(QStringConverter::Latin1);
+}
+
+qint64 TextEncoding::validUtf8(const char *data, qint64 length, bool &truncated)
+{
+	const uchar *begin = reinterpret_cast<const uchar *>(data);
+	const uchar *end = begin + length;
+	const uchar *at = begin;
+	truncated = false;
+	while (at < end)
+	{
+#ifdef TEXTENCODING_SSE2
+		// Most text is long runs of ASCII, which are skipped sixteen bytes at a time.
+		while (end - at >= 16 && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(at))) == 0)
+		{
+			at += 16;
+		}
+
+		if (at == end)
+		{
+			break;
+		}
+#endif
+
+		const int sequence = sequenceLength(at, end);
+		if (sequence <= 0)
+		{
+			truncated = sequence == 0;
+			break;
+		}
+
+		at += sequence;
+	}
+
+	return at - begin;
+}
+
+bool TextEncoding::isAscii(const char *data, qint64 length)
+{
+	qint64 i = 0;
+#ifdef TEXTENCODING_SSE2
+	__m128i high = _mm_setzero_si128();
+	for (; length - i >= 16; i += 16)
+	{
+		high = _mm_or_si128(high, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+	}
+
+	if (_mm_movemask_epi8(high) != 0)
+	{
+		return false;
+	}
+#endif
+
+	for (; i < length; ++i)
+	{
+		if (uchar(data[i]) >= 0x80)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+QStringConverter::Encoding TextEncoding::encoding() const
+{
+	return enc;
+}
+
+bool TextEncoding::hasBom() const
+{
+	return bom;
+}
+
+bool TextEncoding::isUtf8() const
+{
+	return enc == QStringConverter::Utf8;
+}
+
+bool TextEncoding::canEncode(QStringView text) const
+{
+	return enc != QStringConverter::Latin1
+	       || std::all_of(text.begin(), text.end(),
+	                      [](QChar c) { return c.unicode() <= 0xFF || c == QChar::ParagraphSeparator; });
+}
+
+QStringDecoder TextEncoding::decoder() const
+{
+	// The decoder drops a leading byte order mark by itself.
+	return QStringDecoder(enc);
+}
+
+QStringEncoder TextEncoding::encoder() const
+{
+	return QStringEncoder(enc, bom ? QStringConverter::Flag::WriteBom : QStringConverter::Flag::Default);
+}
+
+bool TextEncoding::operator==(TextEncoding const &other) const
+{
+	return enc == other.enc && bom == other.bom;
+}
+
+bool TextEncoding::operator!=(TextEncoding const &other) const
+{
+	return !(*this == other);
+}
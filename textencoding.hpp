@@ -0,0 +1,55 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** textencoding.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QStringDecoder>
+#include <QStringEncoder>
+
+// The encoding a file was found in, kept so it is written back the way it was read.
+class TextEncoding
+{
+public:
+	TextEncoding(QStringConverter::Encoding encoding = QStringConverter::Utf8, bool bom = false);
+
+	// Decides from the start of a file.  A byte order mark settles it, UTF-16 without one shows up as zero bytes in
+	// every other position, and anything else that is not valid UTF-8 is taken for Latin-1.  When atEnd is false more
+	// of the file follows, so a sequence cut off at the end of the sample is not held against UTF-8.
+	static TextEncoding detect(const char *data, qint64 length, bool atEnd);
+	// Length of the longest prefix made of whole, valid UTF-8 sequences.  Truncated is set when all that follows is
+	// the start of a sequence that more bytes could still complete.
+	static qint64 validUtf8(const char *data, qint64 length, bool &truncated);
+	static bool isAscii(const char *data, qint64 length);
+
+	QStringConverter::Encoding encoding() const;
+	bool hasBom() const;
+	bool isUtf8() const;
+	// Whether the text survives a round trip, which only Latin-1 can fail.  Paragraph separators count as the line
+	// breaks they stand for in the raw text of a QTextDocument.
+	bool canEncode(QStringView text) const;
+
+	QStringDecoder decoder() const;
+	QStringEncoder encoder() const;
+
+	bool operator==(TextEncoding const &other) const;
+	bool operator!=(TextEncoding const &other) const;
+
+private:
+	QStringConverter::Encoding enc;
+	bool bom;
+};
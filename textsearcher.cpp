@@ -0,0 +1,787 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** textsearcher.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "textsearcher.hpp"
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTSEARCH_SSE2
+#endif
+
+#include "textbuffer.hpp"
+
+// Units of text scanned by one task of a parallel search.
+constexpr qint64 SEARCH_CHUNK = 1 << 20;
+// Number of compiled expressions kept around.
+constexpr size_t REGEX_CACHE_SIZE = 16;
+// Units read on either side of a chunk, enough to decode the characters around a match for whole word checks.
+constexpr qint64 SEARCH_MARGIN = 4;
+
+namespace
+{
+char16_t fold(char16_t unit, bool caseless)
+{
+	return caseless ? char16_t(QChar::toCaseFolded(char32_t(unit))) : unit;
+}
+
+uchar fold(uchar unit, bool caseless)
+{
+	return caseless && unit >= 'A' && unit <= 'Z' ? uchar(unit + ('a' - 'A')) : unit;
+}
+
+template<typename Char>
+struct Pattern
+{
+	// The needle with its case folded, when searching regardless of case.
+	std::vector<Char> units;
+	bool caseless;
+	// Units which fold to the first and the last unit of the needle, left empty when there are too many to filter.
+	std::array<Char, 4> first, last;
+	int firstCount, lastCount;
+	std::array<qint64, 256> skip;
+#ifdef TEXTSEARCH_SSE2
+	std::array<__m128i, 4> firstSplat, lastSplat;
+#endif
+};
+
+// Every unit that folds to another one, keyed by what it folds to.  Folding is not limited to upper and lower case
+// pairs, the Kelvin sign folds to k for one, so every unit is asked, but only once.
+std::vector<std::pair<char16_t, char16_t>> const &unfoldTable()
+{
+	static const std::vector<std::pair<char16_t, char16_t>> table = [] {
+		std::vector<std::pair<char16_t, char16_t>> pairs;
+		for (char32_t unit = 0; unit <= 0xffff; ++unit)
+		{
+			const char16_t folded = fold(char16_t(unit), true);
+			if (folded != unit)
+			{
+				pairs.emplace_back(folded, char16_t(unit));
+			}
+		}
+
+		std::sort(pairs.begin(), pairs.end());
+		return pairs;
+	}();
+
+	return table;
+}
+
+int unfold(char16_t folded, bool caseless, std::array<char16_t, 4> &variants)
+{
+	variants[0] = folded;
+	if (!caseless)
+	{
+		return 1;
+	}
+
+	int count = fold(folded, true) == folded ? 1 : 0;
+	auto const &table = unfoldTable();
+	for (auto it = std::lower_bound(table.begin(), table.end(), std::make_pair(folded, char16_t(0)));
+	     it != table.end() && it->first == folded; ++it)
+	{
+		if (count == int(variants.size()))
+		{
+			return 0;
+		}
+
+		variants[count++] = it->second;
+	}
+
+	return count;
+}
+
+int unfold(uchar folded, bool caseless, std::array<uchar, 4> &variants)
+{
+	variants[0] = folded;
+	if (caseless && folded >= 'a' && folded <= 'z')
+	{
+		variants[1] = uchar(folded - ('a' - 'A'));
+		return 2;
+	}
+
+	return 1;
+}
+
+#ifdef TEXTSEARCH_SSE2
+__m128i splat(char16_t unit)
+{
+	return _mm_set1_epi16(short(unit));
+}
+
+__m128i splat(uchar unit)
+{
+	return _mm_set1_epi8(char(unit));
+}
+
+__m128i equalUnits(__m128i block, __m128i units, char16_t)
+{
+	return _mm_cmpeq_epi16(block, units);
+}
+
+__m128i equalUnits(__m128i block, __m128i units, uchar)
+{
+	return _mm_cmpeq_epi8(block, units);
+}
+
+template<typename Char>
+__m128i anyOf(const Char *data, std::array<__m128i, 4> const &splats, int count)
+{
+	const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+	__m128i mask = equalUnits(block, splats[0], Char());
+	for (int i = 1; i < count; ++i)
+	{
+		mask = _mm_or_si128(mask, equalUnits(block, splats[i], Char()));
+	}
+
+	return mask;
+}
+#endif
+
+template<typename Char>
+Pattern<Char> makePattern(std::vector<Char> units, bool caseless)
+{
+	Pattern<Char> pattern;
+	for (Char &unit : units)
+	{
+		unit = fold(unit, caseless);
+	}
+
+	pattern.units = std::move(units);
+	pattern.caseless = caseless;
+	pattern.firstCount = unfold(pattern.units.front(), caseless, pattern.first);
+	pattern.lastCount = unfold(pattern.units.back(), caseless, pattern.last);
+
+	// Units are keyed on their low byte, any collision keeps the shorter skip so the scan stays exact.
+	const qint64 length = qint64(pattern.units.size());
+	pattern.skip.fill(length);
+	for (qint64 i = 0; i + 1 < length; ++i)
+	{
+		pattern.skip[pattern.units[size_t(i)] & 0xff] = length - 1 - i;
+	}
+
+#ifdef TEXTSEARCH_SSE2
+	for (int i = 0; i < pattern.firstCount; ++i)
+	{
+		pattern.firstSplat[size_t(i)] = splat(pattern.first[size_t(i)]);
+	}
+
+	for (int i = 0; i < pattern.lastCount; ++i)
+	{
+		pattern.lastSplat[size_t(i)] = splat(pattern.last[size_t(i)]);
+	}
+#endif
+
+	return pattern;
+}
+
+template<typename Char>
+bool equalAt(const Char *data, Pattern<Char> const &pattern)
+{
+	if (!pattern.caseless)
+	{
+		return std::memcmp(data, pattern.units.data(), pattern.units.size() * sizeof(Char)) == 0;
+	}
+
+	for (size_t i = 0; i < pattern.units.size(); ++i)
+	{
+		if (fold(data[i], true) != pattern.units[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Calls found with each position in [from, to) of data where the pattern matches, in order, until it returns false.
+// The data has to be readable for the length of the pattern past to.
+template<typename Char, typename Found>
+bool scan(const Char *data, qint64 from, qint64 to, Pattern<Char> const &pattern, Found const &found)
+{
+	const qint64 lastAt = qint64(pattern.units.size()) - 1;
+#ifdef TEXTSEARCH_SSE2
+	if (pattern.firstCount > 0 && pattern.lastCount > 0)
+	{
+		constexpr qint64 lanes = qint64(sizeof(__m128i) / sizeof(Char));
+		for (; from + lanes <= to; from += lanes)
+		{
+			const __m128i hits = _mm_and_si128(anyOf(data + from, pattern.firstSplat, pattern.firstCount),
+			                                   anyOf(data + from + lastAt, pattern.lastSplat, pattern.lastCount));
+			// Wider units set one mask bit per byte, keep only the first of each.
+			unsigned mask = unsigned(_mm_movemask_epi8(hits)) & (sizeof(Char) == 2 ? 0x5555u : 0xffffu);
+			while (mask != 0)
+			{
+				const qint64 at = from + qint64(qCountTrailingZeroBits(mask) / sizeof(Char));
+				mask &= mask - 1;
+				if (equalAt(data + at, pattern) && !found(at))
+				{
+					return false;
+				}
+			}
+		}
+	}
+#endif
+
+	while (from < to)
+	{
+		const Char tail = fold(data[from + lastAt], pattern.caseless);
+		if (tail == pattern.units.back() && equalAt(data + from, pattern) && !found(from))
+		{
+			return false;
+		}
+
+		from += pattern.skip[tail & 0xff];
+	}
+
+	return true;
+}
+
+// Text read for one chunk, where data[0] is the unit at begin.
+template<typename Char>
+struct Span
+{
+	const Char *data;
+	qint64 begin;
+	qint64 end;
+	QByteArray storage;
+};
+
+bool isWordUnit(Span<char16_t> const &span, qint64 at)
+{
+	return at >= span.begin && at < span.end && QChar(span.data[at - span.begin]).isLetterOrNumber();
+}
+
+bool isWordUnit(Span<uchar> const &span, qint64 at)
+{
+	if (at < span.begin || at >= span.end)
+	{
+		return false;
+	}
+
+	// Back up to the lead byte of the character, then decode just that one.
+	qint64 lead = at;
+	while (lead > span.begin && at - lead < 3 && (span.data[lead - span.begin] & 0xc0) == 0x80)
+	{
+		--lead;
+	}
+
+	const uchar first = span.data[lead - span.begin];
+	const qint64 length = first < 0x80 ? 1 : first < 0xe0 ? 2 : first < 0xf0 ? 3 : 4;
+	const QString decoded = QString::fromUtf8(reinterpret_cast<const char *>(span.data + (lead - span.begin)),
+	                                          std::min(length, span.end - lead));
+	const QList<uint> chars = decoded.toUcs4();
+	return !chars.isEmpty() && QChar::isLetterOrNumber(char32_t(chars.front()));
+}
+
+Span<uchar> bufferSpan(TextBuffer const &buffer, qint64 begin, qint64 end)
+{
+	Span<uchar> span { nullptr, begin, end, buffer.read(begin, end - begin) };
+	span.data = reinterpret_cast<const uchar *>(span.storage.constData());
+	return span;
+}
+
+// Runs work on the calling thread and on up to one helper a chunk from the global pool.  The caller scans as well, so
+// once it runs out of chunks a helper that never got a thread has nothing left to do and is taken back off the queue.
+// Only helpers already running are waited for, which keeps a search started from a thread of the same pool from
+// waiting on helpers stuck behind it.
+void runChunks(qint64 chunks, std::function<void()> const &work)
+{
+	QThreadPool *pool = QThreadPool::globalInstance();
+	const int helpers = int(std::min<qint64>(chunks, pool->maxThreadCount())) - 1;
+	QSemaphore done;
+	std::vector<std::unique_ptr<QRunnable>> tasks;
+	for (int i = 0; i < helpers; ++i)
+	{
+		tasks.emplace_back(QRunnable::create([&work, &done]() {
+			work();
+			done.release();
+		}));
+		tasks.back()->setAutoDelete(false);
+		pool->start(tasks.back().get());
+	}
+
+	work();
+	const auto taken = std::count_if(tasks.begin(), tasks.end(), [pool](std::unique_ptr<QRunnable> const &task) {
+		return pool->tryTake(task.get());
+	});
+	done.acquire(helpers - int(taken));
+}
+
+template<typename Char, typename Fetch>
+qint64 parallelFind(qint64 total, qint64 from, bool backward, bool wholeWords, Pattern<Char> const &pattern,
+                    Fetch const &fetch, std::atomic<bool> const *cancel)
+{
+	// Matches may only start within [low, high).
+	const qint64 length = qint64(pattern.units.size());
+	const qint64 low = backward ? 0 : std::max<qint64>(from, 0);
+	const qint64 high = std::min(backward ? from : total, total - length + 1);
+	if (high <= low)
+	{
+		return -1;
+	}
+
+	const qint64 chunks = (high - low + SEARCH_CHUNK - 1) / SEARCH_CHUNK;
+	std::vector<qint64> results(size_t(chunks), -1);
+	// Chunks are taken nearest first, and none past the nearest one that already holds a match.
+	std::atomic<qint64> next { 0 }, nearest { chunks };
+	auto work = [&]() {
+		for (qint64 order = next++; order < nearest.load(); order = next++)
+		{
+			if (cancel && cancel->load())
+			{
+				break;
+			}
+
+			const qint64 index = backward ? chunks - 1 - order : order;
+			const qint64 start = low + index * SEARCH_CHUNK;
+			const qint64 stop = std::min(high, start + SEARCH_CHUNK);
+			const Span<Char> span = fetch(std::max<qint64>(0, start - SEARCH_MARGIN),
+			                              std::min(total, stop + length - 1 + SEARCH_MARGIN));
+			qint64 hit = -1;
+			scan(span.data, start - span.begin, stop - span.begin, pattern, [&](qint64 at) {
+				at += span.begin;
+				if (wholeWords && (isWordUnit(span, at - 1) || isWordUnit(span, at + length)))
+				{
+					return true;
+				}
+
+				hit = at;
+				return backward;
+			});
+
+			if (hit >= 0)
+			{
+				results[size_t(index)] = hit;
+				qint64 current = nearest.load();
+				while (order < current && !nearest.compare_exchange_weak(current, order))
+				{
+					// Retry with the value that won.
+				}
+			}
+		}
+	};
+
+	runChunks(chunks, work);
+	if (cancel && cancel->load())
+	{
+		return -1;
+	}
+
+	for (qint64 order = 0; order < chunks; ++order)
+	{
+		if (const qint64 hit = results[size_t(backward ? chunks - 1 - order : order)]; hit >= 0)
+		{
+			return hit;
+		}
+	}
+
+	return -1;
+}
+}
+
+TextSearcher::TextSearcher(FindFlags flags, QString const &seek) :
+    seek(seek),
+    seekBytes(seek.toUtf8()),
+    caseSensitivity(flags.test(1) ? Qt::CaseSensitive : Qt::CaseInsensitive),
+    wholeWords(flags.test(2)),
+    useRegex(flags.test(3))
+{
+	if (useRegex)
+	{
+		regex = cachedRegex(seek, caseSensitivity);
+	}
+}
+
+QRegularExpression TextSearcher::cachedRegex(QString const &pattern, Qt::CaseSensitivity caseSensitivity)
+{
+	static QMutex mutex;
+	// Most recently used first.
+	static std::list<QRegularExpression> cache;
+
+	const auto options = caseSensitivity == Qt::CaseInsensitive ? QRegularExpression::CaseInsensitiveOption
+	                                                            : QRegularExpression::NoPatternOption;
+	QMutexLocker locker(&mutex);
+	auto found = std::find_if(cache.begin(), cache.end(), [&](QRegularExpression const &regex) {
+		return regex.pattern() == pattern && regex.patternOptions() == options;
+	});
+
+	if (found != cache.end())
+	{
+		cache.splice(cache.begin(), cache, found);
+		return cache.front();
+	}
+
+	// Compiling here, JIT included where it is available, means every copy handed out shares the compiled pattern.
+	QRegularExpression regex(pattern, options);
+	regex.optimize();
+	cache.push_front(regex);
+	if (cache.size() > REGEX_CACHE_SIZE)
+	{
+		cache.pop_back();
+	}
+
+	return regex;
+}
+
+bool TextSearcher::isValid() const
+{
+	return !seek.isEmpty() && (!useRegex || regex.isValid());
+}
+
+bool TextSearcher::isLiteral() const
+{
+	return !useRegex;
+}
+
+qint64 TextSearcher::byteLength() const
+{
+	return seekBytes.size();
+}
+
+bool TextSearcher::forEachMatch(QString const &text, MatchFunc const &func) const
+{
+	if (!isValid())
+	{
+		return true;
+	}
+
+	if (useRegex)
+	{
+		// Like QTextDocument::find, a match that is not a whole word is passed over.
+		for (QRegularExpressionMatchIterator it = regex.globalMatch(text); it.hasNext();)
+		{
+			const QRegularExpressionMatch match = it.next();
+			if (wholeWords && !isWordAt(text, match.capturedStart(), match.capturedLength()))
+			{
+				continue;
+			}
+
+			if (!func(match.capturedStart(), match.capturedLength()))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	for (qsizetype at = text.indexOf(seek, 0, caseSensitivity); at >= 0;)
+	{
+		if (wholeWords && !isWordAt(text, at, seek.size()))
+		{
+			at = text.indexOf(seek, at + 1, caseSensitivity);
+			continue;
+		}
+
+		if (!func(at, seek.size()))
+		{
+			return false;
+		}
+
+		at = text.indexOf(seek, at + seek.size(), caseSensitivity);
+	}
+
+	return true;
+}
+
+void TextSearcher::setReplacement(QString const &replace)
+{
+	replacement = replace;
+	replaceParts.clear();
+	if (!useRegex)
+	{
+		return;
+	}
+
+	QString literal;
+	for (qsizetype i = 0; i < replace.size(); ++i)
+	{
+		const QChar c = replace[i];
+		const QChar next = i + 1 < replace.size() ? replace[i + 1] : QChar();
+		if ((c == QChar('\\') || c == QChar('$')) && next.isDigit())
+		{
+			int group = next.digitValue();
+			++i;
+			// A second digit only counts when the expression has that many groups, so $10 can still mean $1 and a 0.
+			if (c == QChar('$') && i + 1 < replace.size() && replace[i + 1].isDigit()
+			    && group * 10 + replace[i + 1].digitValue() <= regex.captureCount())
+			{
+				group = group * 10 + replace[++i].digitValue();
+			}
+
+			if (!literal.isEmpty())
+			{
+				replaceParts.push_back({ literal, -1 });
+				literal.clear();
+			}
+
+			replaceParts.push_back({ QString(), group });
+			continue;
+		}
+
+		if ((c == QChar('\\') || c == QChar('$')) && next == c)
+		{
+			++i;
+		}
+
+		literal.append(c);
+	}
+
+	if (!literal.isEmpty())
+	{
+		replaceParts.push_back({ literal, -1 });
+	}
+}
+
+int TextSearcher::replaceInto(QString const &text, QString &out) const
+{
+	int count = 0;
+	qsizetype copied = 0;
+	if (useRegex && isValid())
+	{
+		for (QRegularExpressionMatchIterator it = regex.globalMatch(text); it.hasNext();)
+		{
+			const QRegularExpressionMatch match = it.next();
+			if (wholeWords && !isWordAt(text, match.capturedStart(), match.capturedLength()))
+			{
+				continue;
+			}
+
+			out.append(QStringView(text).mid(copied, match.capturedStart() - copied));
+			appendReplacement(out, match);
+			copied = match.capturedEnd();
+			++count;
+		}
+	}
+	else
+	{
+		forEachMatch(text, [&](qsizetype start, qsizetype length) {
+			out.append(QStringView(text).mid(copied, start - copied));
+			out.append(replacement);
+			copied = start + length;
+			++count;
+			return true;
+		});
+	}
+
+	out.append(QStringView(text).mid(copied));
+	return count;
+}
+
+QString TextSearcher::replacementFor(QString const &text, qsizetype start, qsizetype length) const
+{
+	if (useRegex && isValid())
+	{
+		const QRegularExpressionMatch match = regex.match(text, start, QRegularExpression::NormalMatch,
+		                                                  QRegularExpression::AnchorAtOffsetMatchOption);
+		if (match.hasMatch() && match.capturedLength() == length)
+		{
+			QString out;
+			appendReplacement(out, match);
+			return out;
+		}
+	}
+
+	return replacement;
+}
+
+qint64 TextSearcher::find(QStringView text, qint64 from, bool backward, std::atomic<bool> const *cancel) const
+{
+	if (!isValid() || useRegex)
+	{
+		return -1;
+	}
+
+	const auto pattern = makePattern(std::vector<char16_t>(seek.utf16(), seek.utf16() + seek.size()),
+	                                 caseSensitivity == Qt::CaseInsensitive);
+	return parallelFind(text.size(), from, backward, wholeWords, pattern, [&text](qint64 begin, qint64 end) {
+		return Span<char16_t> { text.utf16() + begin, begin, end, QByteArray() };
+	}, cancel);
+}
+
+qint64 TextSearcher::find(TextBuffer const &buffer, qint64 from, bool backward, std::atomic<bool> const *cancel) const
+{
+	if (!isValid() || useRegex)
+	{
+		return -1;
+	}
+
+	const auto pattern = makePattern(std::vector<uchar>(seekBytes.begin(), seekBytes.end()),
+	                                 caseSensitivity == Qt::CaseInsensitive);
+	return parallelFind(buffer.size(), from, backward, wholeWords, pattern, [&buffer](qint64 begin, qint64 end) {
+		return bufferSpan(buffer, begin, end);
+	}, cancel);
+}
+
+std::vector<qint64> TextSearcher::findAll(TextBuffer const &buffer) const
+{
+	std::vector<qint64> starts;
+	const qint64 length = seekBytes.size();
+	const qint64 high = buffer.size() - length + 1;
+	if (!isValid() || useRegex || high <= 0)
+	{
+		return starts;
+	}
+
+	const auto pattern = makePattern(std::vector<uchar>(seekBytes.begin(), seekBytes.end()),
+	                                 caseSensitivity == Qt::CaseInsensitive);
+	const qint64 chunks = (high + SEARCH_CHUNK - 1) / SEARCH_CHUNK;
+	std::vector<std::vector<qint64>> found(size_t(chunks));
+	std::atomic<qint64> next { 0 };
+	runChunks(chunks, [&]() {
+		for (qint64 index = next++; index < chunks; index = next++)
+		{
+			const qint64 start = index * SEARCH_CHUNK;
+			const qint64 stop = std::min(high, start + SEARCH_CHUNK);
+			const Span<uchar> span = bufferSpan(buffer, std::max<qint64>(0, start - SEARCH_MARGIN),
+			                                    std::min(buffer.size(), stop + length - 1 + SEARCH_MARGIN));
+			scan(span.data, start - span.begin, stop - span.begin, pattern, [&](qint64 at) {
+				at += span.begin;
+				if (!wholeWords || !(isWordUnit(span, at - 1) || isWordUnit(span, at + length)))
+				{
+					found[size_t(index)].push_back(at);
+				}
+
+				return true;
+			});
+		}
+	});
+
+	// The scan reports matches that overlap, of which only the first is kept, the same as replacing one after another.
+	for (std::vector<qint64> const &chunk : found)
+	{
+		for (qint64 at : chunk)
+		{
+			if (starts.empty() || at >= starts.back() + length)
+			{
+				starts.push_back(at);
+			}
+		}
+	}
+
+	return starts;
+}
+
+qint64 TextSearcher::findInRawText(QStringView text, qint64 from, bool backward, qint64 &length,
+                                   std::atomic<bool> const *cancel) const
+{
+	if (!useRegex)
+	{
+		length = seek.size();
+		return find(text, from, backward, cancel);
+	}
+
+	if (!isValid())
+	{
+		return -1;
+	}
+
+	// Like QTextDocument::find, an expression is matched a block at a time, so anchors and lookarounds stop at the
+	// block's edges.  That also gives a slow expression a point to notice it was cancelled between blocks.
+	from = std::clamp<qint64>(from, 0, text.size());
+	qint64 blockStart = text.lastIndexOf(QChar::ParagraphSeparator, std::max<qint64>(from - 1, 0));
+	blockStart = from == 0 || blockStart < 0 ? 0 : blockStart + 1;
+	while (!(cancel && cancel->load()))
+	{
+		qint64 blockEnd = text.indexOf(QChar::ParagraphSeparator, blockStart);
+		blockEnd = blockEnd < 0 ? text.size() : blockEnd;
+		const QString block = text.mid(blockStart, blockEnd - blockStart).toString();
+		qint64 found = -1;
+		for (QRegularExpressionMatchIterator it = regex.globalMatch(block); it.hasNext();)
+		{
+			const QRegularExpressionMatch match = it.next();
+			const qint64 start = blockStart + match.capturedStart();
+			if (match.capturedLength() == 0 || (backward ? start >= from : start < from)
+			    || (wholeWords && !isWordAt(block, match.capturedStart(), match.capturedLength())))
+			{
+				if (backward && start >= from)
+				{
+					break;
+				}
+
+				continue;
+			}
+
+			found = start;
+			length = match.capturedLength();
+			if (!backward)
+			{
+				break;
+			}
+		}
+
+		if (found >= 0)
+		{
+			return found;
+		}
+
+		if (backward ? blockStart == 0 : blockEnd == text.size())
+		{
+			break;
+		}
+
+		if (!backward)
+		{
+			blockStart = blockEnd + 1;
+		}
+		else
+		{
+			// The unit before blockStart is the separator ending the previous block, look for the one before it.
+			blockStart = blockStart >= 2 ? text.lastIndexOf(QChar::ParagraphSeparator, blockStart - 2) + 1 : 0;
+		}
+	}
+
+	return -1;
+}
+
+void TextSearcher::appendReplacement(QString &out, QRegularExpressionMatch const &match) const
+{
+	for (ReplacePart const &part : replaceParts)
+	{
+		if (part.group < 0)
+		{
+			out.append(part.literal);
+		}
+		else
+		{
+			out.append(match.capturedView(part.group));
+		}
+	}
+}
+
+bool TextSearcher::isWordAt(QString const &text, qsizetype start, qsizetype length) const
+{
+	const qsizetype end = start + length;
+	return (start == 0 || !text.at(start - 1).isLetterOrNumber())
+	    && (end == text.size() || !text.at(end).isLetterOrNumber());
+}
@@ -0,0 +1,94 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** textsearcher.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QRegularExpression>
+#include <QString>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "findflags.hpp"
+
+class TextBuffer;
+
+// Finds the matches of one search within runs of text, with the same rules QTextDocument::find applies to a block.
+//
+// Literal searches can also look for the nearest match in a whole text or buffer.  That splits the range into chunks
+// which are scanned in parallel, each with an SSE2 filter on the first and last unit of the needle and a Horspool scan
+// for whatever the filter cannot cover.
+class TextSearcher
+{
+public:
+	// Called with each match in order, stops the search when it returns false.
+	using MatchFunc = std::function<bool(qsizetype start, qsizetype length)>;
+
+	TextSearcher(FindFlags flags, QString const &seek);
+
+	// Compiled and optimized expressions are kept for the most recent patterns, so repeating a search or stepping
+	// through its matches never compiles the pattern again.  May be called from any thread.
+	static QRegularExpression cachedRegex(QString const &pattern, Qt::CaseSensitivity caseSensitivity);
+
+	bool isValid() const;
+	bool isLiteral() const;
+	// Length of a literal match within a buffer, which holds UTF-8.
+	qint64 byteLength() const;
+
+	bool forEachMatch(QString const &text, MatchFunc const &func) const;
+
+	// For a regex search \1 or $1 in the replacement stand for what a capture group matched, \0 or $0 for the whole
+	// match, and \\ or $$ for the character itself.  The replacement is parsed once here rather than for every match.
+	void setReplacement(QString const &replace);
+	// Appends text to out with every match replaced, returns the number of replacements made.
+	int replaceInto(QString const &text, QString &out) const;
+	// Replacement for the given span of text, with the capture groups filled in when the regex matches exactly there.
+	QString replacementFor(QString const &text, qsizetype start, qsizetype length) const;
+
+	// Start of the first literal match at or after from, or of the last one starting before it when searching backward,
+	// or -1 without one or once cancel is set.  In a buffer only ASCII letters match regardless of case.
+	qint64 find(QStringView text, qint64 from, bool backward, std::atomic<bool> const *cancel = nullptr) const;
+	qint64 find(TextBuffer const &buffer, qint64 from, bool backward, std::atomic<bool> const *cancel = nullptr) const;
+	// Start of every literal match in the buffer, in order, leaving out any that overlaps the match before it.
+	std::vector<qint64> findAll(TextBuffer const &buffer) const;
+	// The same for either kind of search, in text laid out like QTextDocument::toRawText, with the length of the
+	// match stored in length.
+	qint64 findInRawText(QStringView text, qint64 from, bool backward, qint64 &length,
+	                     std::atomic<bool> const *cancel = nullptr) const;
+
+private:
+	// A run of the replacement taken as it is, or a capture group to fill in when group is not negative.
+	struct ReplacePart
+	{
+		QString literal;
+		int group;
+	};
+
+	bool isWordAt(QString const &text, qsizetype start, qsizetype length) const;
+	void appendReplacement(QString &out, QRegularExpressionMatch const &match) const;
+
+	QString seek;
+	QByteArray seekBytes;
+	QRegularExpression regex;
+	QString replacement;
+	std::vector<ReplacePart> replaceParts;
+	Qt::CaseSensitivity caseSensitivity;
+	bool wholeWords;
+	bool useRegex;
+};
@@ -0,0 +1,278 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** undohistory.cpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#include "undohistory.hpp"
+
+#include <algorithm>
+
+// Memory a history may take up unless it is given a budget of its own.
+constexpr qint64 DEFAULT_BUDGET = qint64(64) << 20;
+
+namespace
+{
+qint64 budgetForNew = DEFAULT_BUDGET;
+
+// Appends runs, joining the two that meet if the second carries on where the first ends.
+void appendRuns(std::vector<TextBuffer::Extent> &runs, std::vector<TextBuffer::Extent> const &more)
+{
+	auto next = more.begin();
+	if (!runs.empty() && next != more.end() && next->page == runs.back().page
+	    && next->start == runs.back().start + runs.back().length)
+	{
+		runs.back().length += next->length;
+		++next;
+	}
+
+	runs.insert(runs.end(), next, more.end());
+}
+}
+
+UndoHistory::UndoHistory() :
+    limit(budgetForNew),
+    used(0),
+    dropped(0),
+    clean(0),
+    typing(false)
+{
+	// No implementation.
+}
+
+qint64 UndoHistory::defaultBudget()
+{
+	return budgetForNew;
+}
+
+void UndoHistory::setDefaultBudget(qint64 bytes)
+{
+	budgetForNew = std::max<qint64>(0, bytes);
+}
+
+qint64 UndoHistory::budget() const
+{
+	return limit;
+}
+
+void UndoHistory::setBudget(qint64 bytes)
+{
+	limit = std::max<qint64>(0, bytes);
+	trim();
+}
+
+qint64 UndoHistory::memoryUsed() const
+{
+	return used;
+}
+
+int UndoHistory::undoSteps() const
+{
+	return int(undoStack.size());
+}
+
+int UndoHistory::redoSteps() const
+{
+	return int(redoStack.size());
+}
+
+int UndoHistory::droppedSteps() const
+{
+	return dropped;
+}
+
+bool UndoHistory::canUndo() const
+{
+	return !undoStack.empty();
+}
+
+bool UndoHistory::canRedo() const
+{
+	return !redoStack.empty();
+}
+
+void UndoHistory::clear()
+{
+	undoStack.clear();
+	redoStack.clear();
+	used = 0;
+	dropped = 0;
+	clean = -1;
+	typing = false;
+}
+
+void UndoHistory::record(qint64 position, qint64 length, QString const &removed, bool typed)
+{
+	push({ position, length, removed, {} }, typed);
+}
+
+void UndoHistory::record(qint64 position, qint64 length, std::vector<TextBuffer::Extent> removed, bool typed)
+{
+	push({ position, length, QString(), std::move(removed) }, typed);
+}
+
+UndoHistory::Step UndoHistory::takeUndo()
+{
+	Step step = std::move(undoStack.back());
+	undoStack.pop_back();
+	used -= cost(step);
+	typing = false;
+	return step;
+}
+
+UndoHistory::Step UndoHistory::takeRedo()
+{
+	Step step = std::move(redoStack.back());
+	redoStack.pop_back();
+	used -= cost(step);
+	typing = false;
+	return step;
+}
+
+void UndoHistory::pushUndo(Step step)
+{
+	used += cost(step);
+	undoStack.push_back(std::move(step));
+	trim();
+}
+
+void UndoHistory::pushRedo(Step step)
+{
+	used += cost(step);
+	redoStack.push_back(std::move(step));
+	trim();
+}
+
+void UndoHistory::markClean()
+{
+	clean = int(undoStack.size());
+	typing = false;
+}
+
+bool UndoHistory::isClean() const
+{
+	return clean == int(undoStack.size());
+}
+
+void UndoHistory::markUnreachable()
+{
+	clean = -1;
+}
+
+qint64 UndoHistory::removedLength(Step const &step)
+{
+	qint64 length = step.text.size();
+	for (TextBuffer::Extent const &run : step.runs)
+	{
+		length += run.length;
+	}
+
+	return length;
+}
+
+qint64 UndoHistory::cost(Step const &step)
+{
+	return qint64(sizeof(Step)) + step.text.capacity() * qint64(sizeof(QChar))
+	       + qint64(step.runs.capacity() * sizeof(TextBuffer::Extent));
+}
+
+bool UndoHistory::extend(Step &last, Step &step)
+{
+	const qint64 removed = removedLength(step);
+	if (removed == 0 && removedLength(last) == 0 && step.position == last.position + last.length)
+	{
+		last.length += step.length;
+		return true;
+	}
+
+	if (step.length != 0 || last.length != 0 || removed == 0)
+	{
+		return false;
+	}
+
+	if (step.position + removed == last.position)
+	{
+		// Backspace, which takes out the text before what the step already took.
+		last.text.prepend(step.text);
+		appendRuns(step.runs, last.runs);
+		last.runs = std::move(step.runs);
+		last.position = step.position;
+		return true;
+	}
+
+	if (step.position == last.position)
+	{
+		// Delete, which takes out the text after it.
+		last.text.append(step.text);
+		appendRuns(last.runs, step.runs);
+		return true;
+	}
+
+	return false;
+}
+
+void UndoHistory::push(Step step, bool typed)
+{
+	// The saved text can not be redone to anymore.
+	if (clean > int(undoStack.size()))
+	{
+		clean = -1;
+	}
+
+	for (Step const &gone : redoStack)
+	{
+		used -= cost(gone);
+	}
+
+	redoStack.clear();
+	// A step the saved text is at stays as it is, so undoing still gets back there.
+	if (typed && typing && !undoStack.empty() && !isClean())
+	{
+		Step &last = undoStack.back();
+		const qint64 before = cost(last);
+		if (extend(last, step))
+		{
+			used += cost(last) - before;
+			trim();
+			return;
+		}
+	}
+
+	typing = typed;
+	pushUndo(std::move(step));
+}
+
+void UndoHistory::trim()
+{
+	while (used > limit && !undoStack.empty())
+	{
+		used -= cost(undoStack.front());
+		undoStack.pop_front();
+		++dropped;
+		clean = clean > 0 ? clean - 1 : -1;
+	}
+
+	while (used > limit && !redoStack.empty())
+	{
+		used -= cost(redoStack.front());
+		redoStack.pop_front();
+		++dropped;
+	}
+
+	if (clean > int(undoStack.size() + redoStack.size()))
+	{
+		clean = -1;
+	}
+}
@@ -0,0 +1,95 @@
+/***********************************************************************************************************************
+** The Simple Qt Text Editor Application
+** undohistory.hpp
+** Copyright (C) 2024 Ezekiel Oruven
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+** documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+** rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+** Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+** WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+** COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+** OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***********************************************************************************************************************/
+#pragma once
+
+#include <QString>
+
+#include <deque>
+#include <vector>
+
+#include "textbuffer.hpp"
+
+// Undo and redo kept within a budget of memory.  A step only holds the side of an edit that is not in the text right
+// now: what the edit took out is kept, what it put in is still there to be read back when the step is undone, and
+// undoing turns the one into the other for the redo step.  The text of a buffer is kept as the runs of bytes the
+// buffer still has, which cost the same however much text they cover, anything else as a copy.  Keys typed or deleted
+// one after the other add to the same step, and once the steps take up more than the budget the oldest are forgotten.
+class UndoHistory
+{
+public:
+	struct Step
+	{
+		// Where the edit starts and how much it left there, in characters of a document or bytes of a buffer.
+		qint64 position;
+		qint64 length;
+		// What the edit took out, which undoing it puts back.
+		QString text;
+		std::vector<TextBuffer::Extent> runs;
+	};
+
+	UndoHistory();
+
+	// Budget of the histories made from now on.
+	static qint64 defaultBudget();
+	static void setDefaultBudget(qint64 bytes);
+
+	qint64 budget() const;
+	void setBudget(qint64 bytes);
+	// Memory the steps take up, and how many of them were forgotten to stay within the budget since the last clear.
+	qint64 memoryUsed() const;
+	int undoSteps() const;
+	int redoSteps() const;
+	int droppedSteps() const;
+	bool canUndo() const;
+	bool canRedo() const;
+
+	void clear();
+	// Records an edit, which drops whatever there was to redo.  A typed edit goes into the step before it when it
+	// carries on right where that one left off.
+	void record(qint64 position, qint64 length, QString const &removed, bool typed);
+	void record(qint64 position, qint64 length, std::vector<TextBuffer::Extent> removed, bool typed);
+	// Taking a step hands it over to be undone or redone, which makes the step that reverts it again.
+	Step takeUndo();
+	Step takeRedo();
+	void pushUndo(Step step);
+	void pushRedo(Step step);
+
+	// The text as it is now is the saved one.  Undoing or redoing back to it makes it unmodified again.
+	void markClean();
+	bool isClean() const;
+	// The text changed in a way none of the steps records, so no amount of undoing gets back to the saved text.
+	void markUnreachable();
+
+private:
+	static qint64 removedLength(Step const &step);
+	static qint64 cost(Step const &step);
+	// Adds step to the one before it if it carries on from there.
+	static bool extend(Step &last, Step &step);
+	void push(Step step, bool typed);
+	void trim();
+
+	std::deque<Step> undoStack;
+	std::deque<Step> redoStack;
+	qint64 limit;
+	qint64 used;
+	int dropped;
+	// Number of steps to undo at which the text is the saved one, or -1 once that can no longer be reached.
+	int clean;
+	bool typing;
+};